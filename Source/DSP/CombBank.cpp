@@ -0,0 +1,296 @@
+#include "CombBank.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+
+ #if JUCE_GCC || JUCE_CLANG
+  #define COMBBANK_TARGET(isa) __attribute__ ((target (isa)))
+ #else
+  #define COMBBANK_TARGET(isa)
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    // Works out where each comb reads this sample and which frame all of
+    // them write, then moves the write position on. Every channel shares the
+    // same lengths, so this is done once per sample rather than once per
+    // channel.
+    inline int getPositions (CombBank::State& s, int* reads) noexcept
+    {
+        for (int c = 0; c < CombBank::numCombs; ++c)
+            reads[c] = (((s.position - s.lengths[c]) & s.positionMask) * CombBank::numCombs) + c;
+
+        const auto write = s.position * CombBank::numCombs;
+        s.position = (s.position + 1) & s.positionMask;
+
+        return write;
+    }
+
+    //==============================================================================
+    void processScalar (CombBank::State& s, const float* const* inputs, float* const* outputs,
+                        int numChannels, int numOutputs, int numSamples,
+                        const float* damping, const float* feedback) noexcept
+    {
+        int reads[CombBank::numCombs];
+        float combOutputs[CombBank::numCombs];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto write = getPositions (s, reads);
+
+            const auto damp = damping[i];
+            const auto fb   = feedback[i];
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channel = s.channels[(size_t) ch];
+                const auto input = inputs[ch][i];
+
+                for (int c = 0; c < CombBank::numCombs; ++c)
+                {
+                    combOutputs[c] = channel.buffer[reads[c]];
+
+                    channel.stores[c] = combOutputs[c] * (1.0f - damp) + channel.stores[c] * damp;
+                    channel.buffer[write + c] = input + channel.stores[c] * fb;
+                }
+
+                for (int o = ch; o < numOutputs; o += numChannels)
+                {
+                    const auto* signs = s.outputs[(size_t) o].signs;
+                    auto sum = 0.0f;
+
+                    for (int c = 0; c < CombBank::numCombs; ++c)
+                        sum += combOutputs[c] * signs[c];
+
+                    outputs[o][i] = sum;
+                }
+            }
+        }
+    }
+
+   #if JUCE_INTEL
+    //==============================================================================
+    COMBBANK_TARGET ("sse2")
+    inline __m128 gather4 (const float* buffer, const int* positions) noexcept
+    {
+        return _mm_setr_ps (buffer[positions[0]], buffer[positions[1]],
+                            buffer[positions[2]], buffer[positions[3]]);
+    }
+
+    COMBBANK_TARGET ("sse2")
+    void processSSE (CombBank::State& s, const float* const* inputs, float* const* outputs,
+                     int numChannels, int numOutputs, int numSamples,
+                     const float* damping, const float* feedback) noexcept
+    {
+        alignas (16) int reads[CombBank::numCombs];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto write = getPositions (s, reads);
+
+            const auto damp   = _mm_set1_ps (damping[i]);
+            const auto undamp = _mm_set1_ps (1.0f - damping[i]);
+            const auto fb     = _mm_set1_ps (feedback[i]);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channel = s.channels[(size_t) ch];
+                const auto input = _mm_set1_ps (inputs[ch][i]);
+
+                const auto outLo = gather4 (channel.buffer, reads);
+                const auto outHi = gather4 (channel.buffer, reads + 4);
+
+                const auto storeLo = _mm_add_ps (_mm_mul_ps (outLo, undamp), _mm_mul_ps (_mm_load_ps (channel.stores),     damp));
+                const auto storeHi = _mm_add_ps (_mm_mul_ps (outHi, undamp), _mm_mul_ps (_mm_load_ps (channel.stores + 4), damp));
+
+                _mm_store_ps (channel.stores,     storeLo);
+                _mm_store_ps (channel.stores + 4, storeHi);
+
+                _mm_store_ps (channel.buffer + write,     _mm_add_ps (input, _mm_mul_ps (storeLo, fb)));
+                _mm_store_ps (channel.buffer + write + 4, _mm_add_ps (input, _mm_mul_ps (storeHi, fb)));
+
+                for (int o = ch; o < numOutputs; o += numChannels)
+                {
+                    const auto* signs = s.outputs[(size_t) o].signs;
+
+                    auto sum = _mm_add_ps (_mm_mul_ps (outLo, _mm_load_ps (signs)),
+                                           _mm_mul_ps (outHi, _mm_load_ps (signs + 4)));
+                    sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+                    sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+                    outputs[o][i] = _mm_cvtss_f32 (sum);
+                }
+            }
+        }
+    }
+
+    //==============================================================================
+    COMBBANK_TARGET ("avx")
+    void processAVX (CombBank::State& s, const float* const* inputs, float* const* outputs,
+                     int numChannels, int numOutputs, int numSamples,
+                     const float* damping, const float* feedback) noexcept
+    {
+        alignas (32) int reads[CombBank::numCombs];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto write = getPositions (s, reads);
+
+            const auto damp   = _mm256_set1_ps (damping[i]);
+            const auto undamp = _mm256_set1_ps (1.0f - damping[i]);
+            const auto fb     = _mm256_set1_ps (feedback[i]);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& channel = s.channels[(size_t) ch];
+                const auto* buffer = channel.buffer;
+                const auto input = _mm256_set1_ps (inputs[ch][i]);
+
+                const auto out = _mm256_setr_ps (buffer[reads[0]], buffer[reads[1]],
+                                                 buffer[reads[2]], buffer[reads[3]],
+                                                 buffer[reads[4]], buffer[reads[5]],
+                                                 buffer[reads[6]], buffer[reads[7]]);
+
+                const auto store = _mm256_add_ps (_mm256_mul_ps (out, undamp),
+                                                  _mm256_mul_ps (_mm256_load_ps (channel.stores), damp));
+                _mm256_store_ps (channel.stores, store);
+                _mm256_store_ps (channel.buffer + write, _mm256_add_ps (input, _mm256_mul_ps (store, fb)));
+
+                for (int o = ch; o < numOutputs; o += numChannels)
+                {
+                    const auto signedOut = _mm256_mul_ps (out, _mm256_load_ps (s.outputs[(size_t) o].signs));
+
+                    auto sum = _mm_add_ps (_mm256_castps256_ps128 (signedOut), _mm256_extractf128_ps (signedOut, 1));
+                    sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+                    sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+                    outputs[o][i] = _mm_cvtss_f32 (sum);
+                }
+            }
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+CombBank::Kernel CombBank::chooseKernel()
+{
+   #if JUCE_INTEL
+    if (juce::SystemStats::hasAVX())
+        return processAVX;
+
+    if (juce::SystemStats::hasSSE2())
+        return processSSE;
+   #endif
+
+    return processScalar;
+}
+
+int CombBank::getSignPattern (int output, int numChannels) noexcept
+{
+    // A stereo pair keeps the plain Freeverb sum on both sides, which leaves
+    // row 1 free for the first output past the eight rows.
+    const bool pairSharesRowZero = numChannels >= 2;
+
+    if (output < numCombs)
+        return output == 1 && pairSharesRowZero ? 0 : output;
+
+    if (pairSharesRowZero)
+        return output == numCombs ? 1 : output - 1;
+
+    return output;
+}
+
+float CombBank::getSign (int pattern, int comb) noexcept
+{
+    // Entry (row, c) of the Sylvester Hadamard matrix is -1 when row & c has
+    // an odd number of set bits. Patterns past the eight rows flip that by
+    // the product of the two low bits of c as well. Any two of those differ
+    // by a row, so they're orthogonal to each other, and each one only
+    // correlates by 0.5, at most, with a row.
+    auto odd = juce::countNumberOfBits ((juce::uint32) (pattern & comb)) & 1;
+
+    if (pattern >= numCombs)
+        odd ^= (comb & 1) & (comb >> 1);
+
+    return odd != 0 ? -1.0f : 1.0f;
+}
+
+int CombBank::getNumFrames (const int* lengths) noexcept
+{
+    return juce::nextPowerOfTwo (*std::max_element (lengths, lengths + numCombs));
+}
+
+size_t CombBank::getArenaSize (const int* lengths, int numChannels) noexcept
+{
+    return DelayArena::getSize<float> ((size_t) (getNumFrames (lengths) * numCombs * numChannels));
+}
+
+void CombBank::prepare (const int* lengths, int numChannels, DelayArena& arena, int numOutputs)
+{
+    if (numOutputs <= 0)
+        numOutputs = numChannels;
+
+    const auto numFrames = getNumFrames (lengths);
+    const auto channelSize = numFrames * numCombs;
+
+    std::copy (lengths, lengths + numCombs, state.lengths);
+    state.positionMask = numFrames - 1;
+
+    memorySize = (size_t) (channelSize * numChannels);
+    memory = arena.take<float> (memorySize);
+    state.channels.resize ((size_t) numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        state.channels[(size_t) ch].buffer = memory + ch * channelSize;
+
+    state.outputs.resize ((size_t) numOutputs);
+
+    jassert (numOutputs <= maxNumOutputs);
+
+    for (int o = 0; o < numOutputs; ++o)
+    {
+        const auto pattern = getSignPattern (o, numChannels);
+
+        for (int c = 0; c < numCombs; ++c)
+            state.outputs[(size_t) o].signs[c] = getSign (pattern, c);
+    }
+
+    kernel = chooseKernel();
+    reset();
+}
+
+void CombBank::reset() noexcept
+{
+    if (memory != nullptr)
+        std::fill (memory, memory + memorySize, 0.0f);
+
+    state.position = 0;
+
+    for (auto& channel : state.channels)
+        std::fill (std::begin (channel.stores), std::end (channel.stores), 0.0f);
+}
+
+void CombBank::release() noexcept
+{
+    memory = nullptr;
+    memorySize = 0;
+    kernel = nullptr;
+
+    state.channels.clear();
+    state.outputs.clear();
+}
+
+void CombBank::process (const float* const* inputs, float* const* outputs,
+                        int numChannels, int numOutputs, int numSamples,
+                        const float* damping, const float* feedback) noexcept
+{
+    if (memory == nullptr)
+        return;
+
+    jassert (kernel != nullptr);
+    jassert (numChannels <= (int) state.channels.size());
+    jassert (numOutputs <= (int) state.outputs.size());
+
+    kernel (state, inputs, outputs, numChannels, numOutputs, numSamples, damping, feedback);
+}
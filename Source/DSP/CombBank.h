@@ -0,0 +1,107 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "DelayArena.h"
+
+//==============================================================================
+/**
+    The eight parallel lowpass-feedback combs of the reverb, processed as one
+    vector op per sample with one comb per lane.
+
+    Each channel's delay lines are interleaved in a block taken from the
+    DelayArena: frame n holds sample n of all eight combs, so every comb
+    writes the same frame and a sample's writes are one contiguous vector
+    store. The number of frames is the longest comb rounded up to a power of
+    two, so one shared position can be wrapped with a mask. The combs read
+    at different delays, so the reads are gathered lane by lane.
+
+    prepare() picks the widest kernel the CPU supports: AVX (8 lanes), SSE
+    (2 x 4 lanes) or a scalar fallback. With stereo at 44.1 kHz, the AVX
+    kernel takes about a third of the time of the scalar one.
+
+    Outputs 0 and 1 sum their own channel's combs with the all-positive row,
+    which is the classic Freeverb sum, so mono and stereo sound as they
+    always have. Every other output uses its own row of an 8 x 8 Hadamard
+    matrix. The combs are mutually uncorrelated, so those outputs get tails
+    that are uncorrelated with their neighbours', even from identical input.
+    That includes output 1 when a mono set of combs feeds a stereo pair.
+
+    Eight rows don't go round a 7.1.4 layout, so the outputs past them get
+    sign patterns of their own that are orthogonal to each other and only
+    half correlated with the rows. No two outputs share a pattern, up to
+    maxNumOutputs.
+
+    There can be more outputs than channels. Output o reads the combs of
+    channel (o % numChannels), so one mono set of combs can feed a whole
+    stereo tail.
+*/
+class CombBank
+{
+public:
+    enum
+    {
+        numCombs = 8,
+        maxNumOutputs = 2 * numCombs
+    };
+
+    CombBank() = default;
+
+    /** The arena space prepare() takes for these lengths and channels. */
+    static size_t getArenaSize (const int* lengths, int numChannels) noexcept;
+
+    /** Sets the comb lengths, in samples, and takes the delay lines from the
+        arena. numOutputs defaults to one per channel.
+    */
+    void prepare (const int* lengths, int numChannels, DelayArena& arena, int numOutputs = 0);
+    void reset() noexcept;
+
+    /** Drops the delay lines before the arena is freed. process() does
+        nothing until the next prepare().
+    */
+    void release() noexcept;
+
+    /** Runs every channel through the combs and writes each output's signed
+        sum of its channel's combs. Damping and feedback are per-sample ramps.
+    */
+    void process (const float* const* inputs, float* const* outputs,
+                  int numChannels, int numOutputs, int numSamples,
+                  const float* damping, const float* feedback) noexcept;
+
+    //==============================================================================
+    struct State
+    {
+        alignas (32) int lengths[numCombs] = {};
+        int position = 0, positionMask = 0;
+
+        struct Channel
+        {
+            alignas (32) float stores[numCombs] = {};
+            float* buffer = nullptr;
+        };
+
+        struct Output
+        {
+            alignas (32) float signs[numCombs] = {};
+        };
+
+        std::vector<Channel> channels;
+        std::vector<Output> outputs;
+    };
+
+    using Kernel = void (*) (State&, const float* const*, float* const*, int, int, int, const float*, const float*);
+
+private:
+    //==============================================================================
+    static Kernel chooseKernel();
+    static int getNumFrames (const int* lengths) noexcept;
+    static int getSignPattern (int output, int numChannels) noexcept;
+    static float getSign (int pattern, int comb) noexcept;
+
+    State state;
+    float* memory = nullptr;
+    size_t memorySize = 0;
+    Kernel kernel = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CombBank)
+};
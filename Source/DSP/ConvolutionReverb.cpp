@@ -0,0 +1,329 @@
+#include "ConvolutionReverb.h"
+
+//==============================================================================
+namespace
+{
+    /** A windowed-sinc resampler for impulse responses. The cutoff follows
+        the lower of the two Nyquist frequencies, so going down in rate
+        filters out everything that would otherwise fold back into the band.
+        Runs on the message thread, so it favours accuracy over speed.
+    */
+    class SincResampler
+    {
+    public:
+        SincResampler()
+        {
+            // One side of a Blackman-windowed sinc, tabulated per zero crossing.
+            for (int i = 0; i < (int) table.size(); ++i)
+            {
+                const auto x = (double) i / resolution;
+                const auto sinc = i == 0 ? 1.0 : std::sin (juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+                const auto u = juce::MathConstants<double>::pi * x / zeroCrossings;
+
+                table[(size_t) i] = (float) (sinc * (0.42 + 0.5 * std::cos (u) + 0.08 * std::cos (2.0 * u)));
+            }
+        }
+
+        /** Resamples numInput samples at ratio input samples per output sample. */
+        void process (double ratio, const float* input, int numInput, float* output, int numOutput) const
+        {
+            // The cutoff, in cycles per input sample, sits a little below
+            // Nyquist to leave room for the window's transition band.
+            const auto bandwidth = 0.95 * juce::jmin (1.0, 1.0 / ratio);
+            const auto halfWidth = zeroCrossings / bandwidth;
+
+            for (int n = 0; n < numOutput; ++n)
+            {
+                const auto centre = n * ratio;
+                const auto first = juce::jmax (0, (int) std::ceil (centre - halfWidth));
+                const auto last  = juce::jmin (numInput - 1, (int) std::floor (centre + halfWidth));
+
+                auto sum = 0.0;
+
+                for (int k = first; k <= last; ++k)
+                {
+                    const auto position = std::abs (k - centre) * bandwidth * resolution;
+                    const auto index = (int) position;
+
+                    if (index + 1 >= (int) table.size())
+                        continue;
+
+                    const auto fraction = (float) (position - index);
+                    sum += input[k] * (table[(size_t) index] + fraction * (table[(size_t) index + 1] - table[(size_t) index]));
+                }
+
+                output[n] = (float) (sum * bandwidth);
+            }
+        }
+
+    private:
+        static constexpr int zeroCrossings = 16;
+        static constexpr int resolution = 512;
+
+        std::array<float, zeroCrossings * resolution + 1> table;
+    };
+}
+
+//==============================================================================
+ConvolutionReverb::ConvolutionReverb()
+{
+    setParameters (Parameters());
+}
+
+void ConvolutionReverb::prepare (const juce::dsp::ProcessSpec& newSpec, bool newMonoInput)
+{
+    const juce::ScopedLock sl (impulseLock);
+
+    // The partitions don't depend on the host's block size, so the engine
+    // only needs rebuilding if the rate or the channels changed.
+    const bool needsNewEngine = ! isPrepared
+                                 || newSpec.sampleRate != spec.sampleRate
+                                 || newSpec.numChannels != spec.numChannels
+                                 || newMonoInput != monoInput;
+
+    spec = newSpec;
+    monoInput = newMonoInput;
+    isPrepared = true;
+
+    wetBuffer.setSize ((int) spec.numChannels, (int) spec.maximumBlockSize);
+    inputBuffer.setSize ((int) spec.numChannels, (int) spec.maximumBlockSize);
+
+    const double smoothTime = 0.01;
+    dryGain .reset (spec.sampleRate, smoothTime);
+    wetGain1.reset (spec.sampleRate, smoothTime);
+    wetGain2.reset (spec.sampleRate, smoothTime);
+
+    if (needsNewEngine)
+        swapEngine (createEngine());
+    else
+        reset();
+}
+
+void ConvolutionReverb::reset()
+{
+    const juce::SpinLock::ScopedLockType sl (engineLock);
+
+    if (engine != nullptr)
+        for (auto& c : engine->convolvers)
+            c->reset();
+
+    tankLevel = 0.0f;
+}
+
+void ConvolutionReverb::release()
+{
+    const juce::ScopedLock sl (impulseLock);
+
+    isPrepared = false;
+    swapEngine ({});
+
+    wetBuffer.setSize (0, 0);
+    inputBuffer.setSize (0, 0);
+}
+
+//==============================================================================
+void ConvolutionReverb::setParameters (const Parameters& newParams)
+{
+    const float wetScaleFactor = 2.0f;
+    const float dryScaleFactor = 2.0f;
+
+    const float wet = newParams.wetLevel * wetScaleFactor;
+    dryGain .setTargetValue (newParams.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParams.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParams.width));
+
+    parameters = newParams;
+}
+
+void ConvolutionReverb::setNonRealtime (bool isNonRealtime)
+{
+    const juce::ScopedLock sl (impulseLock);
+    nonRealtime = isNonRealtime;
+
+    const juce::SpinLock::ScopedLockType el (engineLock);
+
+    if (engine != nullptr)
+        for (auto& c : engine->convolvers)
+            c->setNonRealtime (nonRealtime);
+}
+
+//==============================================================================
+void ConvolutionReverb::loadImpulseResponse (juce::AudioBuffer<float>&& newImpulse, double newImpulseSampleRate)
+{
+    const juce::ScopedLock sl (impulseLock);
+
+    impulse = std::move (newImpulse);
+    impulseSampleRate = newImpulseSampleRate;
+    impulseLengthSeconds.store (impulseSampleRate > 0.0 ? impulse.getNumSamples() / impulseSampleRate : 0.0,
+                                std::memory_order_relaxed);
+
+    if (isPrepared)
+        swapEngine (createEngine());
+}
+
+void ConvolutionReverb::clearImpulseResponse()
+{
+    loadImpulseResponse ({}, 0.0);
+}
+
+std::unique_ptr<ConvolutionReverb::Engine> ConvolutionReverb::createEngine()
+{
+    const juce::ScopedLock sl (impulseLock);
+
+    if (impulse.getNumChannels() == 0 || impulse.getNumSamples() == 0 || spec.numChannels == 0)
+        return {};
+
+    // Bring the IR to the processing rate, and scale it so that the loudest
+    // channel has the same energy whatever file was loaded.
+    const auto ratio = impulseSampleRate > 0.0 ? impulseSampleRate / spec.sampleRate : 1.0;
+    const auto length = juce::jmax (1, (int) (impulse.getNumSamples() / ratio));
+
+    juce::AudioBuffer<float> resampled (impulse.getNumChannels(), length);
+    resampled.clear();
+
+    if (ratio == 1.0)
+    {
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+            resampled.copyFrom (ch, 0, impulse, ch, 0, length);
+    }
+    else
+    {
+        const SincResampler resampler;
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+            resampler.process (ratio, impulse.getReadPointer (ch), impulse.getNumSamples(),
+                               resampled.getWritePointer (ch), length);
+    }
+
+    auto maxEnergy = 0.0f;
+
+    for (int ch = 0; ch < resampled.getNumChannels(); ++ch)
+    {
+        auto energy = 0.0f;
+
+        for (auto* s = resampled.getReadPointer (ch), *end = s + length; s != end; ++s)
+            energy += *s * *s;
+
+        maxEnergy = juce::jmax (maxEnergy, energy);
+    }
+
+    if (maxEnergy > 0.0f)
+        for (int ch = 0; ch < resampled.getNumChannels(); ++ch)
+            resampled.applyGain (ch, 0, length, 0.5f / std::sqrt (maxEnergy));
+
+    auto newEngine = std::make_unique<Engine>();
+    newEngine->impulseLength = length;
+
+    // With a mono input, channels that share an IR channel would produce
+    // the same wet signal, so they share a convolver too.
+    const auto numConvolvers = monoInput ? juce::jmin ((int) spec.numChannels, resampled.getNumChannels())
+                                         : (int) spec.numChannels;
+
+    for (int ch = 0; ch < numConvolvers; ++ch)
+    {
+        auto convolver = std::make_unique<NonUniformConvolver>();
+        convolver->prepare (resampled.getReadPointer (ch % resampled.getNumChannels()), length);
+        convolver->setWorker (&worker, newEngine->backgroundStages);
+        convolver->setNonRealtime (nonRealtime);
+        newEngine->convolvers.push_back (std::move (convolver));
+    }
+
+    return newEngine;
+}
+
+void ConvolutionReverb::swapEngine (std::unique_ptr<Engine> newEngine)
+{
+    auto backgroundStages = newEngine != nullptr ? newEngine->backgroundStages
+                                                 : std::vector<UniformConvolver*>();
+
+    tailLengthSamples.store (newEngine != nullptr ? newEngine->impulseLength : 0, std::memory_order_relaxed);
+
+    {
+        const juce::SpinLock::ScopedLockType sl (engineLock);
+        std::swap (engine, newEngine);
+    }
+
+    // Once this returns the worker can't be touching the old engine, which
+    // is then freed here, outside the lock.
+    worker.setConvolvers (std::move (backgroundStages));
+}
+
+//==============================================================================
+template <typename SampleType>
+void ConvolutionReverb::process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    tankLevel = 0.0f;
+
+    // Unprepared, or released, the dry signal just passes through.
+    if (context.isBypassed || ! isPrepared || wetBuffer.getNumSamples() == 0)
+        return;
+
+    auto& block = context.getOutputBlock();
+    const auto numChannels = (int) block.getNumChannels();
+    const auto maxBlockSize = (size_t) wetBuffer.getNumSamples();
+
+    jassert (numChannels <= wetBuffer.getNumChannels());
+
+    const juce::SpinLock::ScopedTryLockType tl (engineLock);
+    auto* current = tl.isLocked() ? engine.get() : nullptr;
+
+    for (size_t offset = 0; offset < block.getNumSamples(); offset += maxBlockSize)
+    {
+        const auto n = (int) juce::jmin (maxBlockSize, block.getNumSamples() - offset);
+
+        wetBuffer.clear();
+
+        const auto numConvolvers = current != nullptr ? juce::jmin (numChannels, (int) current->convolvers.size()) : 1;
+
+        if (current != nullptr)
+        {
+            for (int ch = 0; ch < numConvolvers; ++ch)
+            {
+                const auto* input = block.getChannelPointer ((size_t) (monoInput ? 0 : ch)) + offset;
+                const float* floatInput;
+
+                if constexpr (std::is_same<SampleType, float>::value)
+                {
+                    floatInput = input;
+                }
+                else
+                {
+                    auto* converted = inputBuffer.getWritePointer (ch);
+
+                    for (int i = 0; i < n; ++i)
+                        converted[i] = (float) input[i];
+
+                    floatInput = converted;
+                }
+
+                current->convolvers[(size_t) ch]->process (floatInput, wetBuffer.getWritePointer (ch), n);
+                tankLevel = juce::jmax (tankLevel, wetBuffer.getMagnitude (ch, 0, n));
+            }
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const auto wet1 = wetGain1.getNextValue();
+            const auto wet2 = wetGain2.getNextValue();
+            const auto dry  = dryGain.getNextValue();
+
+            auto total = 0.0f;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                total += wetBuffer.getSample (ch % numConvolvers, i);
+
+            // Channel 0 goes last, as with a mono input it's everyone's dry.
+            for (int ch = numChannels; --ch >= 0;)
+            {
+                const auto own = wetBuffer.getSample (ch % numConvolvers, i);
+                const auto others = numChannels > 1 ? (total - own) / (float) (numChannels - 1) : 0.0f;
+
+                const auto input = block.getChannelPointer ((size_t) (monoInput ? 0 : ch))[offset + (size_t) i];
+                block.getChannelPointer ((size_t) ch)[offset + (size_t) i] = (SampleType) (own * wet1 + others * wet2) + input * (SampleType) dry;
+            }
+        }
+    }
+}
+
+template void ConvolutionReverb::process<float>  (const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void ConvolutionReverb::process<double> (const juce::dsp::ProcessContextReplacing<double>&) noexcept;
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "NonUniformConvolver.h"
+
+//==============================================================================
+/**
+    Impulse-response reverb built on NonUniformConvolver, with one convolver
+    per channel. Channel ch uses IR channel (ch % the IR's channel count).
+
+    The convolvers have no latency, so the dry path is mixed in directly and
+    nothing needs reporting to the host. The large tail partitions run on a
+    ConvolutionWorker, so the audio callback only does the head and the small
+    partitions. Takes the same Parameters as the algorithmic engines. Only
+    the levels and width apply.
+*/
+class ConvolutionReverb
+{
+public:
+    using Parameters = juce::dsp::Reverb::Parameters;
+
+    ConvolutionReverb();
+
+    //==============================================================================
+    /** With monoInput, only channel 0 of each block carries input, and
+        output channels that use the same IR channel share one convolver.
+    */
+    void prepare (const juce::dsp::ProcessSpec& spec, bool monoInput = false);
+    void reset();
+
+    /** Frees the convolvers and buffers until the next prepare(). The IR
+        itself is kept, so prepare() can rebuild them.
+    */
+    void release();
+
+    void setParameters (const Parameters& newParams);
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    /** Offline renders wait for the worker's late jobs instead of dropping
+        them. Call this before prepare().
+    */
+    void setNonRealtime (bool isNonRealtime);
+
+    /** The convolvers only work in single precision, so double input is
+        converted a sub-block at a time on its way in.
+    */
+    template <typename SampleType>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    /** Replaces the impulse response. Call this from any thread but the
+        audio thread. The new partitions are built here and swapped in
+        before the next block.
+    */
+    void loadImpulseResponse (juce::AudioBuffer<float>&& newImpulse, double newImpulseSampleRate);
+
+    /** Drops the impulse response, after which the dry signal passes through. */
+    void clearImpulseResponse();
+
+    bool hasImpulseResponse() const noexcept { return getTailLengthSeconds() > 0.0; }
+
+    /** The length of the loaded impulse response, which is also the tail.
+        Doesn't wait for an impulse response that's still being loaded.
+    */
+    double getTailLengthSeconds() const noexcept { return impulseLengthSeconds.load (std::memory_order_relaxed); }
+
+    /** The same, in samples at the processing rate. Safe on the audio thread. */
+    int getTailLengthSamples() const noexcept { return tailLengthSamples.load (std::memory_order_relaxed); }
+
+    /** The peak of the convolvers' output over the last process() call,
+        before the wet gain.
+    */
+    float getTankLevel() const noexcept { return tankLevel; }
+
+private:
+    //==============================================================================
+    struct Engine
+    {
+        std::vector<std::unique_ptr<NonUniformConvolver>> convolvers;
+        std::vector<UniformConvolver*> backgroundStages;
+        int impulseLength = 0;
+    };
+
+    std::unique_ptr<Engine> createEngine();
+    void swapEngine (std::unique_ptr<Engine> newEngine);
+
+    Parameters parameters;
+    juce::dsp::ProcessSpec spec { 44100.0, 512, 2 };
+    bool isPrepared = false;
+    bool monoInput = false;
+    bool nonRealtime = false;
+
+    // Also guards the spec, so that an impulse response loaded on another
+    // thread can't be built for a half-changed one.
+    juce::CriticalSection impulseLock;
+    juce::AudioBuffer<float> impulse;
+    double impulseSampleRate = 0.0;
+    std::atomic<double> impulseLengthSeconds { 0.0 };
+
+    juce::SpinLock engineLock;
+    std::unique_ptr<Engine> engine;
+    std::atomic<int> tailLengthSamples { 0 };
+
+    juce::AudioBuffer<float> wetBuffer, inputBuffer;
+    juce::SmoothedValue<float> dryGain, wetGain1, wetGain2;
+    float tankLevel = 0.0f;
+
+    // Declared last so it stops before the engine it serves is freed.
+    ConvolutionWorker worker;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionReverb)
+};
@@ -0,0 +1,82 @@
+#include "ConvolutionWorker.h"
+#include "UniformConvolver.h"
+
+//==============================================================================
+namespace
+{
+    // JUCE 7.0.6 added real-time threads and replaced the numeric priorities
+    // with Thread::Priority, so startThread (int) doesn't build there. The
+    // overload taking int is only picked when startRealtimeThread() exists.
+    template <typename ThreadType>
+    auto startHighPriorityThread (ThreadType& thread, int)
+        -> decltype (thread.startRealtimeThread (typename ThreadType::RealtimeOptions{}), void())
+    {
+        thread.startRealtimeThread (typename ThreadType::RealtimeOptions{});
+    }
+
+    // Older JUCE versions have no real-time threads. 10 is the highest of
+    // their normal priorities, so the OS can still hold the worker back
+    // behind other busy threads, and its late jobs are then dropped.
+    template <typename ThreadType>
+    void startHighPriorityThread (ThreadType& thread, long)
+    {
+        thread.startThread (10);
+    }
+}
+
+//==============================================================================
+ConvolutionWorker::ConvolutionWorker()
+    : juce::Thread ("Convolution worker")
+{
+}
+
+ConvolutionWorker::~ConvolutionWorker()
+{
+    stop();
+}
+
+void ConvolutionWorker::setConvolvers (std::vector<UniformConvolver*> newConvolvers)
+{
+    std::sort (newConvolvers.begin(), newConvolvers.end(),
+               [] (const UniformConvolver* a, const UniformConvolver* b) { return a->getBlockSize() < b->getBlockSize(); });
+
+    const bool needsThread = ! newConvolvers.empty();
+
+    {
+        const juce::ScopedLock sl (convolversLock);
+        convolvers = std::move (newConvolvers);
+    }
+
+    if (needsThread)
+        start();
+    else
+        stop();
+}
+
+void ConvolutionWorker::start()
+{
+    if (isThreadRunning())
+        return;
+
+    startHighPriorityThread (static_cast<juce::Thread&> (*this), 0);
+}
+
+void ConvolutionWorker::stop()
+{
+    signalThreadShouldExit();
+    jobQueued.signal();
+    stopThread (1000);
+}
+
+void ConvolutionWorker::run()
+{
+    while (! threadShouldExit())
+    {
+        jobQueued.wait (100);
+
+        const juce::ScopedLock sl (convolversLock);
+
+        for (auto* convolver : convolvers)
+            convolver->runPendingJob();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+class UniformConvolver;
+
+//==============================================================================
+/**
+    A high-priority thread that computes the output of the large tail
+    partitions of a convolution between audio callbacks. It only runs while
+    it has convolvers to serve, so an instance that never loads a long
+    enough impulse response never starts it.
+
+    Each background UniformConvolver queues one job per block and collects
+    it one block later. The worker runs the queued jobs shortest block size
+    first, which is also earliest deadline first. If a job hasn't started by
+    its deadline, the audio thread takes it back and runs it itself. In real
+    time, one the worker is still in the middle of is dropped rather than
+    waited for, so the audio thread never blocks on the worker.
+*/
+class ConvolutionWorker  : private juce::Thread
+{
+public:
+    ConvolutionWorker();
+    ~ConvolutionWorker() override;
+
+    /** Replaces the convolvers the worker serves. Blocks until any job from
+        the old set has finished, so they can be deleted straight afterwards.
+        Starts the thread if there are any convolvers, and stops it if there
+        are none. Call this off the audio thread.
+    */
+    void setConvolvers (std::vector<UniformConvolver*> newConvolvers);
+
+    /** Called from the audio thread when a job has been queued. */
+    void wake() noexcept { jobQueued.signal(); }
+
+private:
+    void run() override;
+
+    void start();
+    void stop();
+
+    juce::CriticalSection convolversLock;
+    std::vector<UniformConvolver*> convolvers;
+    juce::WaitableEvent jobQueued;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionWorker)
+};
@@ -0,0 +1,30 @@
+#include "DelayArena.h"
+
+//==============================================================================
+void DelayArena::allocate (size_t numBytes)
+{
+    if (base != nullptr && numBytes == capacity)
+    {
+        std::fill (base, base + capacity, 0);
+        used = 0;
+        return;
+    }
+
+    release();
+
+    // Over-allocate by one line so the start can be rounded up to one.
+    storage.calloc (numBytes + cacheLineSize);
+
+    const auto address = reinterpret_cast<juce::pointer_sized_uint> (storage.get());
+    const auto aligned = (address + cacheLineSize - 1) & ~(juce::pointer_sized_uint) (cacheLineSize - 1);
+
+    base = storage.get() + (aligned - address);
+    capacity = numBytes;
+}
+
+void DelayArena::release() noexcept
+{
+    storage.free();
+    base = nullptr;
+    capacity = used = 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    One contiguous, zeroed block that holds the delay lines of every engine.
+
+    The processor asks each engine how much it needs, allocates the total in
+    prepareToPlay() and hands the arena to the engines' prepare(), where they
+    take their lines from it in order. Every block taken starts on a cache
+    line and is padded to a whole number of cache lines. The lines are all a
+    power of two long, so they're also cache-line multiples and can be
+    indexed with a mask.
+
+    Pointers taken from the arena are only valid until the next allocate()
+    or release().
+*/
+class DelayArena
+{
+public:
+    static constexpr size_t cacheLineSize = 64;
+
+    DelayArena() = default;
+
+    /** The space numElements of T take in the arena. */
+    template <typename T>
+    static constexpr size_t getSize (size_t numElements) noexcept
+    {
+        return (numElements * sizeof (T) + cacheLineSize - 1) & ~(cacheLineSize - 1);
+    }
+
+    /** Frees the old block and allocates a zeroed one of at least numBytes.
+        If the block is already numBytes long it's kept and just cleared, so
+        re-preparing at the same rate and layout doesn't touch the heap.
+    */
+    void allocate (size_t numBytes);
+
+    /** Frees the block. */
+    void release() noexcept;
+
+    /** Takes the next numElements of T from the arena. */
+    template <typename T>
+    T* take (size_t numElements) noexcept
+    {
+        static_assert (alignof (T) <= cacheLineSize, "The arena only aligns to cache lines");
+
+        const auto size = getSize<T> (numElements);
+        jassert (used + size <= capacity);
+
+        auto* result = reinterpret_cast<T*> (base + used);
+        used += size;
+        return result;
+    }
+
+    size_t getCapacity() const noexcept { return capacity; }
+
+private:
+    juce::HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t capacity = 0, used = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayArena)
+};
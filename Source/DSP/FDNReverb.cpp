@@ -0,0 +1,297 @@
+#include "FDNReverb.h"
+
+//==============================================================================
+FDNReverb::FDNReverb()
+{
+    setParameters (Parameters());
+}
+
+int FDNReverb::getLineLength (double sampleRate, int line) noexcept
+{
+    // Mutually prime lengths, spread so the modes don't pile up (at 44100Hz)
+    static const short lineTunings[] = { 601, 683, 773, 859, 941, 1031, 1109, 1201,
+                                         1297, 1381, 1471, 1553, 1657, 1747, 1867, 1979 };
+
+    return juce::jmax (1, (int) (sampleRate * lineTunings[line] / 44100.0));
+}
+
+size_t FDNReverb::getArenaSize (const juce::dsp::ProcessSpec& spec, bool doublePrecision) noexcept
+{
+    size_t totalLength = 0;
+
+    for (int j = 0; j < numLines; ++j)
+        totalLength += (size_t) juce::nextPowerOfTwo (getLineLength (spec.sampleRate, j));
+
+    return doublePrecision ? DelayArena::getSize<double> (totalLength)
+                           : DelayArena::getSize<float> (totalLength);
+}
+
+void FDNReverb::prepare (const juce::dsp::ProcessSpec& spec, DelayArena& arena,
+                         bool newMonoInput, bool newDoublePrecision)
+{
+    jassert (spec.numChannels <= (juce::uint32) numLines);
+
+    sampleRate  = spec.sampleRate;
+    numChannels = (int) spec.numChannels;
+    monoInput   = newMonoInput;
+    doublePrecision = newDoublePrecision;
+
+    int totalLength = 0;
+    positionMask = 0;
+
+    for (int j = 0; j < numLines; ++j)
+    {
+        const auto length = getLineLength (sampleRate, j);
+        const auto paddedLength = juce::nextPowerOfTwo (length);
+
+        offsets[j] = totalLength;
+        lengths[j] = length;
+        masks[j] = paddedLength - 1;
+        positionMask = juce::jmax (positionMask, masks[j]);
+        totalLength += paddedLength;
+    }
+
+    memorySize = (size_t) totalLength;
+
+    if (doublePrecision)
+        memory = arena.take<double> (memorySize);
+    else
+        memory = arena.take<float> (memorySize);
+
+    wetOutput.assign ((size_t) (numChannels * (int) spec.maximumBlockSize), 0.0f);
+
+    const double smoothTime = 0.01;
+    decayTime.reset (sampleRate, smoothTime);
+    damping .reset (sampleRate, smoothTime);
+    dryGain .reset (sampleRate, smoothTime);
+    wetGain1.reset (sampleRate, smoothTime);
+    wetGain2.reset (sampleRate, smoothTime);
+
+    reset();
+}
+
+void FDNReverb::reset()
+{
+    if (memory != nullptr)
+    {
+        if (doublePrecision)
+            std::fill_n (static_cast<double*> (memory), memorySize, 0.0);
+        else
+            std::fill_n (static_cast<float*> (memory), memorySize, 0.0f);
+    }
+
+    position = 0;
+    std::fill (std::begin (stores), std::end (stores), 0.0f);
+    std::fill (std::begin (doubleStores), std::end (doubleStores), 0.0);
+    tankLevel = 0.0f;
+}
+
+void FDNReverb::release()
+{
+    memory = nullptr;
+    memorySize = 0;
+    numChannels = 0;
+    wetOutput = {};
+}
+
+//==============================================================================
+void FDNReverb::setParameters (const Parameters& newParams)
+{
+    const float wetScaleFactor = 3.0f;
+    const float dryScaleFactor = 2.0f;
+    const float dampScaleFactor = 0.6f;
+
+    const float wet = newParams.wetLevel * wetScaleFactor;
+    dryGain .setTargetValue (newParams.dryLevel * dryScaleFactor);
+    wetGain1.setTargetValue (0.5f * wet * (1.0f + newParams.width));
+    wetGain2.setTargetValue (0.5f * wet * (1.0f - newParams.width));
+
+    decayTime.setTargetValue (getDecaySeconds (newParams.roomSize));
+
+    const bool frozen = isFrozen (newParams.freezeMode);
+    damping.setTargetValue (frozen ? 0.0f : newParams.damping * dampScaleFactor);
+    inputGain = frozen ? 0.0f : 0.06f;
+
+    parameters = newParams;
+}
+
+float FDNReverb::getDecaySeconds (float roomSize) noexcept
+{
+    const float minDecay = 0.3f;
+    const float maxDecay = 12.0f;
+
+    // Room size maps exponentially onto the RT60 of the tank.
+    return minDecay * std::pow (maxDecay / minDecay, roomSize);
+}
+
+double FDNReverb::getTailLengthSeconds (const Parameters& params) noexcept
+{
+    if (isFrozen (params.freezeMode))
+        return std::numeric_limits<double>::infinity();
+
+    // The lines are lowpassed, so the lows decay slowest, at the full RT60.
+    return 2.0 * getDecaySeconds (params.roomSize);
+}
+
+void FDNReverb::updateLineGains (float decaySeconds) noexcept
+{
+    if (isFrozen (parameters.freezeMode))
+    {
+        std::fill (std::begin (lineGains), std::end (lineGains), 1.0f);
+        std::fill (std::begin (doubleLineGains), std::end (doubleLineGains), 1.0);
+        return;
+    }
+
+    // -60 dB after decaySeconds, whatever the length of each line.
+    const auto dbPerSample = -60.0 / (decaySeconds * sampleRate);
+
+    for (int j = 0; j < numLines; ++j)
+    {
+        doubleLineGains[j] = std::pow (10.0, dbPerSample * lengths[j] / 20.0);
+        lineGains[j] = (float) doubleLineGains[j];
+    }
+}
+
+//==============================================================================
+template <typename TankType>
+void FDNReverb::hadamard (TankType* data) noexcept
+{
+    // Fast Walsh-Hadamard transform. The sizes are all fixed, so the compiler
+    // can unroll the butterfly stages into vector add/subs.
+    for (int stride = 1; stride < numLines; stride *= 2)
+    {
+        for (int start = 0; start < numLines; start += 2 * stride)
+        {
+            for (int k = start; k < start + stride; ++k)
+            {
+                const auto a = data[k];
+                const auto b = data[k + stride];
+                data[k]          = a + b;
+                data[k + stride] = a - b;
+            }
+        }
+    }
+
+    const auto normalisation = (TankType) 0.25; // 1 / sqrt (numLines)
+
+    for (int j = 0; j < numLines; ++j)
+        data[j] *= normalisation;
+}
+
+template <typename SampleType>
+void FDNReverb::process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    tankLevel = 0.0f;
+
+    // Unprepared, or released, the dry signal just passes through.
+    if (context.isBypassed || memory == nullptr || wetOutput.empty())
+        return;
+
+    if (doublePrecision)
+        processTank<double> (context);
+    else
+        processTank<float> (context);
+}
+
+template <typename TankType, typename SampleType>
+void FDNReverb::processTank (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    auto* lines = static_cast<TankType*> (memory);
+    auto* lineStores = getStores<TankType>();
+    const auto* gains = getLineGains<TankType>();
+
+    auto& block = context.getOutputBlock();
+    const auto blockChannels = (int) block.getNumChannels();
+
+    jassert (blockChannels <= numChannels);
+
+    if (blockChannels == 0)
+        return;
+
+    const auto maxBlockSize = wetOutput.size() / (size_t) numChannels;
+
+    // With more channels each one taps fewer lines. Scale every channel to
+    // the level of a stereo tap set, so layouts from mono to 7.1.4 come out
+    // equally loud and balanced.
+    alignas (32) float tapGains[numLines];
+
+    for (int ch = 0; ch < blockChannels; ++ch)
+    {
+        const auto numTaps = (numLines - ch + blockChannels - 1) / blockChannels;
+        tapGains[ch] = std::sqrt ((float) (numLines / 2) / (float) numTaps);
+    }
+
+    for (size_t offset = 0; offset < block.getNumSamples(); offset += maxBlockSize)
+    {
+        const auto n = (int) juce::jmin (maxBlockSize, block.getNumSamples() - offset);
+
+        updateLineGains (decayTime.skip (n));
+
+        alignas (32) TankType outputs[numLines];
+        alignas (32) TankType feedback[numLines];
+
+        for (int i = 0; i < n; ++i)
+        {
+            const auto damp = (TankType) damping.getNextValue();
+
+            for (int j = 0; j < numLines; ++j)
+            {
+                outputs[j] = lines[offsets[j] + ((position - lengths[j]) & masks[j])];
+                tankLevel = juce::jmax (tankLevel, (float) std::abs (outputs[j]));
+            }
+
+            for (int j = 0; j < numLines; ++j)
+            {
+                lineStores[j] = outputs[j] * ((TankType) 1 - damp) + lineStores[j] * damp;
+                feedback[j]   = lineStores[j];
+            }
+
+            hadamard (feedback);
+
+            for (int j = 0; j < numLines; ++j)
+            {
+                const auto inputChannel = monoInput ? 0 : j % blockChannels;
+                const auto input = (TankType) block.getChannelPointer ((size_t) inputChannel)[offset + (size_t) i];
+                lines[offsets[j] + (position & masks[j])] = feedback[j] * gains[j] + input * (TankType) inputGain;
+            }
+
+            position = (position + 1) & positionMask;
+
+            for (int ch = 0; ch < blockChannels; ++ch)
+            {
+                TankType sum = 0;
+
+                for (int j = ch; j < numLines; j += blockChannels)
+                    sum += outputs[j];
+
+                wetOutput[(size_t) (ch * (int) maxBlockSize + i)] = (float) sum * tapGains[ch];
+            }
+        }
+
+        // Mix each channel's taps with the average of the others for width.
+        for (int i = 0; i < n; ++i)
+        {
+            const auto wet1 = wetGain1.getNextValue();
+            const auto wet2 = wetGain2.getNextValue();
+            const auto dry  = dryGain.getNextValue();
+
+            auto total = 0.0f;
+
+            for (int ch = 0; ch < blockChannels; ++ch)
+                total += wetOutput[(size_t) (ch * (int) maxBlockSize + i)];
+
+            // Channel 0 goes last, as with a mono input it's everyone's dry.
+            for (int ch = blockChannels; --ch >= 0;)
+            {
+                const auto own = wetOutput[(size_t) (ch * (int) maxBlockSize + i)];
+                const auto others = blockChannels > 1 ? (total - own) / (float) (blockChannels - 1) : 0.0f;
+
+                const auto input = block.getChannelPointer ((size_t) (monoInput ? 0 : ch))[offset + (size_t) i];
+                block.getChannelPointer ((size_t) ch)[offset + (size_t) i] = (SampleType) (own * wet1 + others * wet2) + input * (SampleType) dry;
+            }
+        }
+    }
+}
+
+template void FDNReverb::process<float>  (const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void FDNReverb::process<double> (const juce::dsp::ProcessContextReplacing<double>&) noexcept;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#include "DelayArena.h"
+
+//==============================================================================
+/**
+    A 16-line feedback delay network reverb.
+
+    Every line has a one-pole lowpass for damping, and the lines are mixed
+    through a normalised 16 x 16 Hadamard matrix, applied as four butterfly
+    stages. The lines are kept as arrays with one entry per line, so the
+    damping, mixing and decay gains are all flat loops that the compiler can
+    vectorise. The lines live in a DelayArena, each padded to a power of two
+    and indexed from one shared write position with a mask.
+
+    Channel ch feeds and taps every line whose index modulo the channel count
+    is ch, so all channels share one tank but get decorrelated tails. Works
+    for up to numLines channels. Takes the same parameters as
+    ReverbEngine, so the processor can switch between the two.
+
+    The lines run in single precision, unless prepare() is asked for double
+    ones. A frozen tank recirculates forever, so float rounding slowly eats
+    into its tail, and a host that processes in double can have the lines,
+    the damping and the mixing matrix in double too.
+*/
+class FDNReverb
+{
+public:
+    using Parameters = juce::dsp::Reverb::Parameters;
+
+    enum
+    {
+        numLines = 16
+    };
+
+    FDNReverb();
+
+    //==============================================================================
+    /** With monoInput, only channel 0 of each block carries input. It feeds
+        every line, and every channel still taps its own lines.
+        With doublePrecision, the lines hold doubles, whichever sample type
+        process() is then called with.
+    */
+    void prepare (const juce::dsp::ProcessSpec& spec, DelayArena& arena,
+                  bool monoInput = false, bool doublePrecision = false);
+
+    /** The arena space prepare() takes for this spec. */
+    static size_t getArenaSize (const juce::dsp::ProcessSpec& spec, bool doublePrecision = false) noexcept;
+    void reset();
+
+    /** Drops the lines, which are about to be freed with the arena, and the
+        wet buffer. process() leaves blocks untouched until the next prepare().
+    */
+    void release();
+
+    void setParameters (const Parameters& newParams);
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    /** How long the tail takes to fall by 120 dB with these parameters, or
+        infinity when frozen.
+    */
+    static double getTailLengthSeconds (const Parameters& params) noexcept;
+
+    /** The peak of the line outputs over the last process() call. Stays up
+        while the tank rings, whatever the wet level.
+    */
+    float getTankLevel() const noexcept { return tankLevel; }
+
+    /** The tank runs at the precision picked in prepare(). The wet taps are
+        mixed in single precision either way.
+    */
+    template <typename SampleType>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+private:
+    //==============================================================================
+    template <typename TankType, typename SampleType>
+    void processTank (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    template <typename TankType>
+    static void hadamard (TankType* data) noexcept;
+
+    template <typename TankType>
+    TankType* getStores() noexcept
+    {
+        if constexpr (std::is_same<TankType, double>::value)
+            return doubleStores;
+        else
+            return stores;
+    }
+
+    template <typename TankType>
+    const TankType* getLineGains() const noexcept
+    {
+        if constexpr (std::is_same<TankType, double>::value)
+            return doubleLineGains;
+        else
+            return lineGains;
+    }
+
+    void updateLineGains (float decaySeconds) noexcept;
+    static bool isFrozen (float freezeMode) noexcept { return freezeMode >= 0.5f; }
+    static float getDecaySeconds (float roomSize) noexcept;
+    static int getLineLength (double sampleRate, int line) noexcept;
+
+    Parameters parameters;
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+    bool monoInput = false;
+    bool doublePrecision = false;
+
+    alignas (32) int offsets[numLines] = {};
+    alignas (32) int lengths[numLines] = {};
+    alignas (32) int masks[numLines] = {};
+    alignas (32) float stores[numLines] = {};
+    alignas (32) float lineGains[numLines] = {};
+    alignas (32) double doubleStores[numLines] = {};
+    alignas (32) double doubleLineGains[numLines] = {};
+    int position = 0, positionMask = 0;
+
+    void* memory = nullptr;     // floats, or doubles with doublePrecision
+    size_t memorySize = 0;
+
+    std::vector<float> wetOutput;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> decayTime;
+    juce::SmoothedValue<float> damping, dryGain, wetGain1, wetGain2;
+    float inputGain = 0.0f;
+    float tankLevel = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FDNReverb)
+};
@@ -0,0 +1,89 @@
+#include "NonUniformConvolver.h"
+
+//==============================================================================
+void NonUniformConvolver::prepare (const float* impulse, int impulseLength)
+{
+    headTaps.assign ((size_t) headLength, 0.0f);
+
+    for (int k = 0; k < juce::jmin ((int) headLength, impulseLength); ++k)
+        headTaps[(size_t) (headLength - 1 - k)] = impulse[k];
+
+    history.assign ((size_t) (2 * headLength), 0.0f);
+    stages.clear();
+
+    // Each stage's block size is 4x the last, and it starts at twice its own
+    // block size. The final stage takes everything that's left.
+    static const int blockSizes[] = { 64, 256, 1024, 4096 };
+    const int numStages = (int) (sizeof (blockSizes) / sizeof (blockSizes[0]));
+
+    int start = headLength;
+
+    for (int s = 0; s < numStages && start < impulseLength; ++s)
+    {
+        const auto blockSize = blockSizes[s];
+        const auto end = s + 1 < numStages ? juce::jmin (impulseLength, 2 * blockSizes[s + 1])
+                                           : impulseLength;
+
+        jassert (start % blockSize == 0 && start >= blockSize);
+
+        auto stage = std::make_unique<UniformConvolver>();
+        stage->prepare (impulse + start, end - start, blockSize, start / blockSize - 1);
+        stages.push_back (std::move (stage));
+
+        start = end;
+    }
+
+    reset();
+}
+
+void NonUniformConvolver::reset() noexcept
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    historyPosition = 0;
+
+    for (auto& stage : stages)
+        stage->reset();
+}
+
+void NonUniformConvolver::setWorker (ConvolutionWorker* worker, std::vector<UniformConvolver*>& backgroundStages)
+{
+    for (auto& stage : stages)
+    {
+        if (stage->getBlockSize() < minBackgroundBlockSize)
+            continue;
+
+        stage->setWorker (worker);
+
+        if (stage->isInBackground())
+            backgroundStages.push_back (stage.get());
+    }
+}
+
+void NonUniformConvolver::setNonRealtime (bool isNonRealtime) noexcept
+{
+    for (auto& stage : stages)
+        stage->setNonRealtime (isNonRealtime);
+}
+
+//==============================================================================
+void NonUniformConvolver::process (const float* input, float* output, int numSamples) noexcept
+{
+    for (auto& stage : stages)
+        stage->process (input, output, numSamples);
+
+    // The history holds every input twice, so the newest headLength samples
+    // are always one contiguous run and the FIR is a plain dot product.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        historyPosition = (historyPosition + 1) % headLength;
+        history[(size_t) historyPosition] = history[(size_t) (historyPosition + headLength)] = input[i];
+
+        const auto* recent = history.data() + historyPosition + 1;
+        auto sum = 0.0f;
+
+        for (int k = 0; k < headLength; ++k)
+            sum += headTaps[(size_t) k] * recent[k];
+
+        output[i] += sum;
+    }
+}
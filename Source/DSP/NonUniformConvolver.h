@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "UniformConvolver.h"
+
+//==============================================================================
+/**
+    Zero-latency convolution of one channel with a whole impulse response.
+
+    The first headLength taps run as a direct-form FIR, so output starts on
+    the same sample as the input. The rest of the IR is split into segments
+    handled by UniformConvolvers whose block size grows by 4x each time:
+
+        [0, 64)        direct form
+        [64, 512)      64-sample partitions
+        [512, 2048)    256-sample partitions
+        [2048, 8192)   1024-sample partitions
+        [8192, end)    4096-sample partitions
+
+    Every segment starts at a multiple of its block size, and at least one
+    block in, so its convolver's own latency is hidden behind the segments
+    before it. That extra block is also the slack that lets setWorker() move
+    the large stages onto a background thread.
+*/
+class NonUniformConvolver
+{
+public:
+    enum
+    {
+        headLength = 64
+    };
+
+    NonUniformConvolver() = default;
+
+    void prepare (const float* impulse, int impulseLength);
+    void reset() noexcept;
+
+    /** Moves the stages with partitions of minBackgroundBlockSize or more onto
+        the worker, and adds them to backgroundStages.
+    */
+    void setWorker (ConvolutionWorker* worker, std::vector<UniformConvolver*>& backgroundStages);
+
+    static constexpr int minBackgroundBlockSize = 1024;
+
+    /** See UniformConvolver::setNonRealtime(). */
+    void setNonRealtime (bool isNonRealtime) noexcept;
+
+    /** Convolves numSamples of input and adds the result to output. */
+    void process (const float* input, float* output, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    std::vector<float> headTaps;   // the head of the IR, reversed
+    std::vector<float> history;    // the last headLength inputs, stored twice
+    int historyPosition = 0;
+
+    std::vector<std::unique_ptr<UniformConvolver>> stages;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NonUniformConvolver)
+};
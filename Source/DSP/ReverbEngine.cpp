@@ -0,0 +1,280 @@
+#include "ReverbEngine.h"
+
+//==============================================================================
+namespace
+{
+    const short combTunings[]    = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 }; // (at 44100Hz)
+    const short allPassTunings[] = { 556, 441, 341, 225 };
+    const int stereoSpread = 23;
+
+    void getCombLengths (double sampleRate, int* lengths) noexcept
+    {
+        for (int i = 0; i < CombBank::numCombs; ++i)
+            lengths[i] = ((int) sampleRate * combTunings[i]) / 44100;
+    }
+
+    int getAllPassLength (double sampleRate, int index, int group) noexcept
+    {
+        return ((int) sampleRate * (allPassTunings[index] + group * stereoSpread)) / 44100;
+    }
+}
+
+//==============================================================================
+void ReverbEngine::AllPassFilter::prepare (int size, DelayArena& arena)
+{
+    const auto paddedSize = juce::nextPowerOfTwo (size);
+
+    buffer = arena.take<Lanes> ((size_t) paddedSize);
+    bufferSize = size;
+    mask = paddedSize - 1;
+
+    clear();
+}
+
+void ReverbEngine::AllPassFilter::clear() noexcept
+{
+    if (buffer != nullptr)
+        std::fill (buffer, buffer + mask + 1, Lanes::expand (0.0f));
+
+    bufferIndex = 0;
+}
+
+void ReverbEngine::AllPassFilter::release() noexcept
+{
+    buffer = nullptr;
+    bufferSize = bufferIndex = mask = 0;
+}
+
+size_t ReverbEngine::AllPassFilter::getArenaSize (int size) noexcept
+{
+    return DelayArena::getSize<Lanes> ((size_t) juce::nextPowerOfTwo (size));
+}
+
+//==============================================================================
+ReverbEngine::ReverbEngine()
+{
+    setParameters (Parameters());
+}
+
+size_t ReverbEngine::getArenaSize (const juce::dsp::ProcessSpec& spec, bool monoInput) noexcept
+{
+    const int numChannels = (int) spec.numChannels;
+    const int numInputs = monoInput ? juce::jmin (1, numChannels) : numChannels;
+    const int groups = (numChannels + (int) Lanes::size() - 1) / (int) Lanes::size();
+
+    int combLengths[CombBank::numCombs];
+    getCombLengths (spec.sampleRate, combLengths);
+
+    auto size = CombBank::getArenaSize (combLengths, numInputs);
+
+    for (int g = 0; g < groups; ++g)
+        for (int i = 0; i < numAllPasses; ++i)
+            size += AllPassFilter::getArenaSize (getAllPassLength (spec.sampleRate, i, g));
+
+    return size;
+}
+
+void ReverbEngine::prepare (const juce::dsp::ProcessSpec& spec, DelayArena& arena, bool newMonoInput)
+{
+    jassert (spec.numChannels <= (juce::uint32) getMaxNumChannels());
+
+    const int numChannels = (int) spec.numChannels;
+    const int blockSize = (int) spec.maximumBlockSize;
+
+    numGroups = (numChannels + (int) Lanes::size() - 1) / (int) Lanes::size();
+    maxBlockSize = blockSize;
+    monoInput = newMonoInput;
+
+    const int numInputs = monoInput ? juce::jmin (1, numChannels) : numChannels;
+
+    int combLengths[CombBank::numCombs];
+    getCombLengths (spec.sampleRate, combLengths);
+
+    combs.prepare (combLengths, numInputs, arena, numChannels);
+
+    allPasses.resize ((size_t) (numGroups * numAllPasses));
+
+    for (int g = 0; g < numGroups; ++g)
+        for (int i = 0; i < numAllPasses; ++i)
+            allPasses[(size_t) (g * numAllPasses + i)].prepare (getAllPassLength (spec.sampleRate, i, g), arena);
+
+    combInput .setSize (numInputs, blockSize);
+    combOutput.setSize (numChannels, blockSize);
+    dampingRamp .resize ((size_t) blockSize);
+    feedbackRamp.resize ((size_t) blockSize);
+    frames.assign ((size_t) (blockSize * numGroups), Lanes::expand (0.0f));
+
+    const double smoothTime = 0.01;
+    damping .reset (spec.sampleRate, smoothTime);
+    feedback.reset (spec.sampleRate, smoothTime);
+    dryGain .reset (spec.sampleRate, smoothTime);
+    wetGain .reset (spec.sampleRate, smoothTime);
+}
+
+void ReverbEngine::reset()
+{
+    combs.reset();
+
+    for (auto& a : allPasses)
+        a.clear();
+
+    tankLevel = 0.0f;
+}
+
+void ReverbEngine::release()
+{
+    combs.release();
+
+    for (auto& a : allPasses)
+        a.release();
+
+    allPasses.clear();
+    numGroups = maxBlockSize = 0;
+
+    combInput .setSize (0, 0);
+    combOutput.setSize (0, 0);
+    dampingRamp  = {};
+    feedbackRamp = {};
+    frames       = {};
+}
+
+//==============================================================================
+void ReverbEngine::setParameters (const Parameters& newParams)
+{
+    const float wetScaleFactor = 3.0f;
+    const float dryScaleFactor = 2.0f;
+
+    // Each channel runs as its own mono reverb, so only the direct wet gain
+    // applies and width just scales it, as in juce::dsp::Reverb::processMono.
+    const float wet = newParams.wetLevel * wetScaleFactor;
+    dryGain.setTargetValue (newParams.dryLevel * dryScaleFactor);
+    wetGain.setTargetValue (0.5f * wet * (1.0f + newParams.width));
+
+    gain = isFrozen (newParams.freezeMode) ? 0.0f : 0.015f;
+    parameters = newParams;
+    updateDamping();
+}
+
+void ReverbEngine::updateDamping() noexcept
+{
+    const float dampScaleFactor = 0.4f;
+
+    if (isFrozen (parameters.freezeMode))
+    {
+        damping .setTargetValue (0.0f);
+        feedback.setTargetValue (1.0f);
+    }
+    else
+    {
+        damping .setTargetValue (parameters.damping * dampScaleFactor);
+        feedback.setTargetValue (getFeedback (parameters.roomSize));
+    }
+}
+
+double ReverbEngine::getTailLengthSeconds (const Parameters& params) noexcept
+{
+    if (isFrozen (params.freezeMode))
+        return std::numeric_limits<double>::infinity();
+
+    // Damping only makes the highs die away sooner. The lows go round the
+    // combs at the plain feedback gain, so the longest comb sets the length.
+    const double longestCombSeconds = combTunings[CombBank::numCombs - 1] / 44100.0;
+    const double passes = std::log (1.0e-6) / std::log ((double) getFeedback (params.roomSize));
+
+    return passes * longestCombSeconds;
+}
+
+//==============================================================================
+template <typename SampleType>
+void ReverbEngine::process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    tankLevel = 0.0f;
+
+    // Unprepared, or released, the dry signal just passes through.
+    if (context.isBypassed || maxBlockSize == 0)
+        return;
+
+    auto& block = context.getOutputBlock();
+    const auto numChannels = block.getNumChannels();
+
+    jassert (numChannels <= (size_t) combOutput.getNumChannels());
+
+    const auto numInputs = monoInput ? juce::jmin ((size_t) 1, numChannels) : numChannels;
+
+    const auto lanes = Lanes::size();
+    const auto chunkSize = (size_t) maxBlockSize;
+
+    for (size_t offset = 0; offset < block.getNumSamples(); offset += chunkSize)
+    {
+        const auto numSamples = juce::jmin (chunkSize, block.getNumSamples() - offset);
+
+        const auto n = (int) numSamples;
+
+        for (int i = 0; i < n; ++i)
+        {
+            dampingRamp[(size_t) i]  = damping.getNextValue();
+            feedbackRamp[(size_t) i] = feedback.getNextValue();
+        }
+
+        // Run the comb bank on the scaled input, ...
+        for (size_t ch = 0; ch < numInputs; ++ch)
+        {
+            const auto* source = block.getChannelPointer (ch) + offset;
+            auto* destination = combInput.getWritePointer ((int) ch);
+
+            for (int i = 0; i < n; ++i)
+                destination[i] = (float) source[i] * gain;
+        }
+
+        combs.process (combInput.getArrayOfReadPointers(), combOutput.getArrayOfWritePointers(),
+                       (int) numInputs, (int) numChannels, n, dampingRamp.data(), feedbackRamp.data());
+
+        // ... interleave its outputs into lanes, and run each group of
+        // channels through its allpasses in one pass, ...
+        for (size_t first = 0; first < numChannels; first += lanes)
+        {
+            const auto group = first / lanes;
+            const auto groupSize = juce::jmin (lanes, numChannels - first);
+            auto* groupFrames = frames.data() + group * chunkSize;
+            auto* groupAllPasses = allPasses.data() + group * (size_t) numAllPasses;
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto& frame = groupFrames[i];
+                frame = Lanes::expand (0.0f);
+
+                for (size_t lane = 0; lane < groupSize; ++lane)
+                    frame.set (lane, combOutput.getSample ((int) (first + lane), (int) i));
+            }
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto output = groupFrames[i];
+
+                for (int a = 0; a < numAllPasses; ++a)
+                    output = groupAllPasses[a].process (output);
+
+                groupFrames[i] = output;
+            }
+        }
+
+        // ... and mix the lanes back into the dry signal. Channel 0 goes
+        // last, as with a mono input every channel takes its dry from it.
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            const auto wet = wetGain.getNextValue();
+            const auto dry = dryGain.getNextValue();
+
+            for (size_t ch = numChannels; ch-- > 0;)
+            {
+                const auto input = block.getChannelPointer (monoInput ? 0 : ch)[offset + i];
+                const auto wetSample = frames[(ch / lanes) * chunkSize + i].get (ch % lanes);
+                tankLevel = juce::jmax (tankLevel, std::abs (wetSample));
+                block.getChannelPointer (ch)[offset + i] = (SampleType) (wetSample * wet) + input * (SampleType) dry;
+            }
+        }
+    }
+}
+
+template void ReverbEngine::process<float>  (const juce::dsp::ProcessContextReplacing<float>&) noexcept;
+template void ReverbEngine::process<double> (const juce::dsp::ProcessContextReplacing<double>&) noexcept;
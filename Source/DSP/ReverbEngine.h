@@ -0,0 +1,131 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CombBank.h"
+
+//==============================================================================
+/**
+    Freeverb-style reverb that runs every channel through one comb/allpass
+    network. The combs run in a CombBank, one comb per vector lane. The
+    channels are packed into groups of Lanes::size(), and each allpass
+    stores one SIMD register per sample with one channel of its group per
+    lane, so one loop pass processes a whole group.
+
+    The tails are decorrelated per channel. A stereo pair keeps the plain
+    Freeverb comb sum, and the CombBank gives every channel beyond it a
+    sign pattern of its own. Each group's allpasses are stretched by
+    Freeverb's stereo spread, so channels that share a sign pattern still
+    differ. Otherwise this keeps juce::dsp::Reverb's tunings, scale factors
+    and smoothing.
+
+    All the delay lines live in a DelayArena. prepare() still allocates the
+    allpass list, one set per channel group, and the block-sized scratch
+    buffers.
+*/
+class ReverbEngine
+{
+public:
+    using Parameters = juce::dsp::Reverb::Parameters;
+    using Lanes      = juce::dsp::SIMDRegister<float>;
+
+    ReverbEngine();
+
+    //==============================================================================
+    /** With monoInput, only channel 0 of each block carries input. One set
+        of combs runs on it, and every channel of the block gets its own
+        decorrelated tail of it, mixed with the same dry signal.
+
+        Channel 0 comes out the same as the stereo path gives it for identical
+        L/R input. The other channels don't: a stereo pair shares one comb sum
+        between its channels, while here each gets its own sign row.
+    */
+    void prepare (const juce::dsp::ProcessSpec& spec, DelayArena& arena, bool monoInput = false);
+
+    /** The arena space prepare() takes for this spec. */
+    static size_t getArenaSize (const juce::dsp::ProcessSpec& spec, bool monoInput = false) noexcept;
+    void reset();
+
+    /** Drops the delay lines, which are about to be freed with the arena,
+        and the scratch buffers. process() leaves blocks untouched until the
+        next prepare().
+    */
+    void release();
+
+    void setParameters (const Parameters& newParams);
+    const Parameters& getParameters() const noexcept { return parameters; }
+
+    /** Processes every channel of the context's block in place. The block
+        can't have more channels than were passed to prepare().
+        The tank runs in single precision for either sample type. Double
+        input is converted as it enters the combs, and the dry path stays
+        in double.
+    */
+    template <typename SampleType>
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    static constexpr int getMaxNumChannels() noexcept { return 16; }
+
+    /** How long the tail takes to fall by 120 dB with these parameters, or
+        infinity when frozen.
+    */
+    static double getTailLengthSeconds (const Parameters& params) noexcept;
+
+    /** The peak the tank put out over the last process() call, before the
+        wet gain. Stays up while the tank rings, whatever the wet level.
+    */
+    float getTankLevel() const noexcept { return tankLevel; }
+
+private:
+    //==============================================================================
+    class AllPassFilter
+    {
+    public:
+        /** Takes a line of at least size samples, padded to a power of two. */
+        void prepare (int size, DelayArena& arena);
+        void clear() noexcept;
+        void release() noexcept;
+
+        static size_t getArenaSize (int size) noexcept;
+
+        Lanes process (Lanes input) noexcept
+        {
+            auto bufferedValue = buffer[(bufferIndex - bufferSize) & mask];
+            buffer[bufferIndex] = input + bufferedValue * 0.5f;
+            bufferIndex = (bufferIndex + 1) & mask;
+
+            return bufferedValue - input;
+        }
+
+    private:
+        Lanes* buffer = nullptr;
+        int bufferSize = 0, bufferIndex = 0, mask = 0;
+    };
+
+    //==============================================================================
+    void updateDamping() noexcept;
+    static bool isFrozen (float freezeMode) noexcept { return freezeMode >= 0.5f; }
+    static float getFeedback (float roomSize) noexcept { return roomSize * 0.28f + 0.7f; }
+
+    enum
+    {
+        numAllPasses = 4
+    };
+
+    Parameters parameters;
+
+    CombBank combs;
+    std::vector<AllPassFilter> allPasses;   // numAllPasses per channel group
+
+    int numGroups = 0, maxBlockSize = 0;
+    bool monoInput = false;
+
+    juce::AudioBuffer<float> combInput, combOutput;
+    std::vector<float> dampingRamp, feedbackRamp;
+    std::vector<Lanes> frames;              // maxBlockSize per channel group
+
+    juce::SmoothedValue<float> damping, feedback, dryGain, wetGain;
+    float gain = 0.0f;
+    float tankLevel = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ReverbEngine)
+};
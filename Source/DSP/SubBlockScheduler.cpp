@@ -0,0 +1,36 @@
+#include "SubBlockScheduler.h"
+
+//==============================================================================
+bool SubBlockScheduler::addEvent (int sampleOffset, int parameterIndex, float value) noexcept
+{
+    if (numEvents == (int) maxNumEvents)
+        return false;
+
+    // Keep the queue in time order. Changes at the same offset stay in the
+    // order they were added.
+    Event event { juce::jmax (0, sampleOffset), parameterIndex, value };
+    int position = numEvents;
+
+    while (position > 0 && events[(size_t) (position - 1)].sampleOffset > event.sampleOffset)
+    {
+        events[(size_t) position] = events[(size_t) (position - 1)];
+        --position;
+    }
+
+    events[(size_t) position] = event;
+    ++numEvents;
+
+    return true;
+}
+
+void SubBlockScheduler::consume (int numConsumed, int numSamples) noexcept
+{
+    for (int i = numConsumed; i < numEvents; ++i)
+    {
+        auto& event = events[(size_t) (i - numConsumed)];
+        event = events[(size_t) i];
+        event.sampleOffset -= numSamples;
+    }
+
+    numEvents -= numConsumed;
+}
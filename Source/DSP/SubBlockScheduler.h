@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Splits a host block at the sample offsets of queued parameter changes,
+    so that automation lands where it was written rather than at the start
+    of the block.
+
+    Changes that fall within the minimum sub-block size of the previous
+    split are applied at that split instead. This bounds the number of
+    engine calls per block, and a change is never more than the minimum
+    sub-block size early. Changes beyond the end of the block stay queued
+    for the next one.
+
+    Everything here runs on the audio thread and never allocates.
+*/
+class SubBlockScheduler
+{
+public:
+    struct Event
+    {
+        int sampleOffset = 0;
+        int parameterIndex = 0;     // whatever the caller uses to name its parameters
+        float value = 0.0f;
+    };
+
+    enum
+    {
+        maxNumEvents = 128
+    };
+
+    SubBlockScheduler() = default;
+
+    void setMinimumSubBlockSize (int newSize) noexcept   { minimumSubBlockSize = juce::jmax (1, newSize); }
+    int getMinimumSubBlockSize() const noexcept          { return minimumSubBlockSize; }
+
+    /** Queues a change to land sampleOffset samples into the next block.
+        Returns false if the queue is full.
+    */
+    bool addEvent (int sampleOffset, int parameterIndex, float value) noexcept;
+
+    void clear() noexcept { numEvents = 0; }
+
+    /** Calls applyEvent (const Event&) for each change as its sub-block
+        starts, and processSegment (int startSample, int numSamples) for
+        each sub-block in order.
+    */
+    template <typename ApplyEvent, typename ProcessSegment>
+    void process (int numSamples, ApplyEvent&& applyEvent, ProcessSegment&& processSegment)
+    {
+        int next = 0;
+
+        for (int start = 0; start < numSamples;)
+        {
+            const auto mergeLimit = juce::jmin (numSamples, start + minimumSubBlockSize);
+
+            while (next < numEvents && events[(size_t) next].sampleOffset < mergeLimit)
+                applyEvent (events[(size_t) next++]);
+
+            const auto end = next < numEvents ? juce::jmin (numSamples, events[(size_t) next].sampleOffset)
+                                              : numSamples;
+
+            processSegment (start, end - start);
+            start = end;
+        }
+
+        consume (next, numSamples);
+    }
+
+private:
+    void consume (int numConsumed, int numSamples) noexcept;
+
+    std::array<Event, maxNumEvents> events;
+    int numEvents = 0;
+    int minimumSubBlockSize = 32;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SubBlockScheduler)
+};
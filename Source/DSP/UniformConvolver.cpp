@@ -0,0 +1,314 @@
+#include "UniformConvolver.h"
+
+//==============================================================================
+void UniformConvolver::prepare (const float* impulse, int impulseLength, int newBlockSize, int newSlotOffset)
+{
+    jassert (juce::isPowerOfTwo (newBlockSize));
+
+    blockSize  = newBlockSize;
+    slotOffset = newSlotOffset;
+
+    const auto fftSize = 2 * blockSize;
+    fft = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 (fftSize)));
+
+    numBins   = blockSize + 1;
+    numChunks = (numBins + (int) Lanes::size() - 1) / (int) Lanes::size();
+
+    numPartitions = juce::jmax (1, (impulseLength + blockSize - 1) / blockSize);
+    // One spare slot for convolvers that can run in the background, so a
+    // job can run up to two blocks late before its oldest input is due to be
+    // overwritten.
+    numSlots      = slotOffset + numPartitions + (slotOffset >= 1 ? 1 : 0);
+
+    const auto spectrumSize = (size_t) (2 * numChunks);
+
+    partitions .assign (spectrumSize * (size_t) numPartitions, Lanes::expand (0.0f));
+    delayLine  .assign (spectrumSize * (size_t) numSlots, Lanes::expand (0.0f));
+    accumulator.assign (spectrumSize, Lanes::expand (0.0f));
+
+    // No slot has been written in any generation yet.
+    generation = 1;
+    slotGenerations.assign ((size_t) numSlots, 0);
+    lostSlots.assign ((size_t) numSlots, 0);
+    anyLostSlots = false;
+    currentSlot = 0;
+
+    inputBuffer  .assign ((size_t) fftSize, 0.0f);
+    outputBuffer .assign ((size_t) blockSize, 0.0f);
+    jobOutput    .assign ((size_t) blockSize, 0.0f);
+    fftBuffer    .assign ((size_t) (2 * fftSize), 0.0f);
+    inverseBuffer.assign ((size_t) (2 * fftSize), 0.0f);
+
+    // Each partition is zero-padded to the FFT size, so the last blockSize
+    // samples of every circular convolution are the linear result.
+    std::vector<float> segment ((size_t) fftSize, 0.0f);
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        std::fill (segment.begin(), segment.end(), 0.0f);
+
+        const auto start = p * blockSize;
+        const auto length = juce::jmin (blockSize, impulseLength - start);
+
+        if (length > 0)
+            std::copy (impulse + start, impulse + start + length, segment.begin());
+
+        forward (segment.data(), partitions.data() + spectrumSize * (size_t) p);
+    }
+
+    reset();
+}
+
+void UniformConvolver::reset() noexcept
+{
+    // This can run on the audio thread, so it doesn't wait for the worker.
+    // A job that hasn't started is cancelled, and one that has will finish
+    // with a generation that no longer matches and be ignored.
+    auto expected = (int) jobQueued;
+    jobState.compare_exchange_strong (expected, jobIdle, std::memory_order_acq_rel);
+
+    // Generation 0 marks slots that hold nothing.
+    if (++generation == 0)
+        ++generation;
+
+    std::fill (inputBuffer.begin(), inputBuffer.end(), 0.0f);
+    std::fill (outputBuffer.begin(), outputBuffer.end(), 0.0f);
+
+    inputPosition = 0;
+}
+
+void UniformConvolver::setWorker (ConvolutionWorker* newWorker) noexcept
+{
+    // Only called off the audio thread, before any worker serves this
+    // convolver, or after it has stopped.
+    jassert (jobState.load() != jobRunning);
+    jobState = jobIdle;
+
+    worker = slotOffset >= 1 ? newWorker : nullptr;
+
+    if (worker != nullptr && jobFFT == nullptr)
+        jobFFT = std::make_unique<juce::dsp::FFT> (juce::roundToInt (std::log2 (2 * blockSize)));
+}
+
+//==============================================================================
+void UniformConvolver::multiplyAccumulate (const Lanes* a, const Lanes* b, Lanes* acc, int numChunks) noexcept
+{
+    const auto* aIm = a + numChunks;
+    const auto* bIm = b + numChunks;
+    auto* accIm = acc + numChunks;
+
+    for (int c = 0; c < numChunks; ++c)
+    {
+        acc[c]   += a[c] * b[c]   - aIm[c] * bIm[c];
+        accIm[c] += a[c] * bIm[c] + aIm[c] * b[c];
+    }
+}
+
+void UniformConvolver::forward (const float* timeDomain, Lanes* spectrum) noexcept
+{
+    const auto fftSize = 2 * blockSize;
+
+    std::copy (timeDomain, timeDomain + fftSize, fftBuffer.begin());
+    std::fill (fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+
+    fft->performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+    auto* re = reinterpret_cast<float*> (spectrum);
+    auto* im = re + numChunks * (int) Lanes::size();
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        re[k] = fftBuffer[(size_t) (2 * k)];
+        im[k] = fftBuffer[(size_t) (2 * k + 1)];
+    }
+
+    for (int k = numBins; k < numChunks * (int) Lanes::size(); ++k)
+        re[k] = im[k] = 0.0f;
+}
+
+//==============================================================================
+void UniformConvolver::process (const float* input, float* output, int numSamples) noexcept
+{
+    while (numSamples > 0)
+    {
+        const auto numToDo = juce::jmin (numSamples, blockSize - inputPosition);
+
+        std::copy (input, input + numToDo, inputBuffer.begin() + blockSize + inputPosition);
+        juce::FloatVectorOperations::add (output, outputBuffer.data() + inputPosition, numToDo);
+
+        inputPosition += numToDo;
+        input  += numToDo;
+        output += numToDo;
+        numSamples -= numToDo;
+
+        if (inputPosition == blockSize)
+        {
+            processBlock();
+            inputPosition = 0;
+        }
+    }
+}
+
+void UniformConvolver::processBlock() noexcept
+{
+    if (worker == nullptr)
+    {
+        pushInput();
+        computeOutput (currentSlot, generation, outputBuffer.data());
+        currentSlot = (currentSlot + 1) % numSlots;
+        return;
+    }
+
+    // Collect the output the worker made for this block, then queue the next
+    // one. It only reads slots up to the one written here, so it can run
+    // while the audio thread carries on.
+    collectJob();
+
+    pushInput();
+    currentSlot = (currentSlot + 1) % numSlots;
+
+    // A job the worker is still running holds the job buffers, so the next
+    // one can't be queued yet. collectJob() then does it here next time.
+    if (jobState.load (std::memory_order_acquire) != jobRunning)
+    {
+        forgetLostSlots();
+
+        jobSlot = currentSlot;
+        jobGeneration = generation;
+        jobState.store (jobQueued, std::memory_order_release);
+        worker->wake();
+    }
+}
+
+void UniformConvolver::runPendingJob() noexcept
+{
+    auto expected = (int) jobQueued;
+
+    if (jobState.compare_exchange_strong (expected, jobRunning, std::memory_order_acq_rel))
+    {
+        computeOutput (jobSlot, jobGeneration, jobOutput.data());
+        jobState.store (jobDone, std::memory_order_release);
+    }
+}
+
+void UniformConvolver::collectJob() noexcept
+{
+    // Past the deadline: take the job back if the worker hasn't started it.
+    runPendingJob();
+
+    if (nonRealtime)
+        while (jobState.load (std::memory_order_acquire) == jobRunning)
+            std::this_thread::yield();
+
+    const auto state = jobState.load (std::memory_order_acquire);
+
+    if (state == jobRunning)
+    {
+        // The worker is late. Waiting for it would hold up the audio thread,
+        // so this block goes without the segment's output.
+        std::fill (outputBuffer.begin(), outputBuffer.end(), 0.0f);
+    }
+    else if (state == jobDone && jobSlot == currentSlot && jobGeneration == generation)
+    {
+        std::copy (jobOutput.begin(), jobOutput.end(), outputBuffer.begin());
+    }
+    else
+    {
+        // Nothing was queued for this block, because the worker was still
+        // busy or the convolver has just been reset, so it's done here.
+        forgetLostSlots();
+        computeOutput (currentSlot, generation, outputBuffer.data());
+    }
+}
+
+void UniformConvolver::pushInput() noexcept
+{
+    const auto spectrumSize = (size_t) (2 * numChunks);
+
+    if (isReadByRunningJob (currentSlot))
+    {
+        // The worker is so late that it's still reading the slot this block
+        // goes in. Rather than overwrite it under the worker, the block is
+        // left out of this segment, and the slot counts as silence once the
+        // worker has finished.
+        lostSlots[(size_t) currentSlot] = 1;
+        anyLostSlots = true;
+    }
+    else
+    {
+        forward (inputBuffer.data(), delayLine.data() + spectrumSize * (size_t) currentSlot);
+        slotGenerations[(size_t) currentSlot] = generation;
+        lostSlots[(size_t) currentSlot] = 0;
+    }
+
+    std::copy (inputBuffer.begin() + blockSize, inputBuffer.end(), inputBuffer.begin());
+}
+
+bool UniformConvolver::isReadByRunningJob (int slot) const noexcept
+{
+    // No job can be queued here, as collectJob() takes back any the worker
+    // hasn't started.
+    if (worker == nullptr || jobState.load (std::memory_order_acquire) != jobRunning)
+        return false;
+
+    const auto age = ((jobSlot - slotOffset - slot) % numSlots + numSlots) % numSlots;
+    return age < numPartitions;
+}
+
+void UniformConvolver::forgetLostSlots() noexcept
+{
+    if (! anyLostSlots)
+        return;
+
+    for (size_t slot = 0; slot < lostSlots.size(); ++slot)
+    {
+        if (lostSlots[slot] != 0)
+            slotGenerations[slot] = 0;
+
+        lostSlots[slot] = 0;
+    }
+
+    anyLostSlots = false;
+}
+
+void UniformConvolver::computeOutput (int newestSlot, juce::uint32 slotGeneration, float* destination) noexcept
+{
+    const auto spectrumSize = (size_t) (2 * numChunks);
+    const auto fftSize = 2 * blockSize;
+
+    std::fill (accumulator.begin(), accumulator.end(), Lanes::expand (0.0f));
+
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto slot = ((newestSlot - slotOffset - p) % numSlots + numSlots) % numSlots;
+
+        // Input from before the last reset counts as silence.
+        if (slotGenerations[(size_t) slot] != slotGeneration)
+            continue;
+
+        multiplyAccumulate (delayLine.data() + spectrumSize * (size_t) slot,
+                            partitions.data() + spectrumSize * (size_t) p,
+                            accumulator.data(), numChunks);
+    }
+
+    // Back to JUCE's interleaved layout, with the negative frequencies filled
+    // in as the conjugates of the positive ones.
+    const auto* re = reinterpret_cast<const float*> (accumulator.data());
+    const auto* im = re + numChunks * (int) Lanes::size();
+
+    for (int k = 0; k < numBins; ++k)
+    {
+        inverseBuffer[(size_t) (2 * k)]     = re[k];
+        inverseBuffer[(size_t) (2 * k + 1)] = im[k];
+    }
+
+    for (int k = numBins; k < fftSize; ++k)
+    {
+        inverseBuffer[(size_t) (2 * k)]     =  re[fftSize - k];
+        inverseBuffer[(size_t) (2 * k + 1)] = -im[fftSize - k];
+    }
+
+    (jobFFT != nullptr ? jobFFT : fft)->performRealOnlyInverseTransform (inverseBuffer.data());
+
+    std::copy (inverseBuffer.begin() + blockSize, inverseBuffer.begin() + fftSize, destination);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ConvolutionWorker.h"
+
+//==============================================================================
+/**
+    Uniformly partitioned overlap-save convolution of one channel with one
+    segment of an impulse response.
+
+    The segment is split into partitions of blockSize samples and each one is
+    transformed once in prepare(). Every blockSize input samples, the newest
+    input spectrum goes into a frequency-domain delay line, and the output
+    spectrum is built with one complex multiply-accumulate per partition.
+    Spectra are stored split into real and imaginary arrays of SIMD
+    registers, so the multiply-accumulate is straight vector arithmetic.
+
+    Output lags the input by blockSize samples. slotOffset delays the segment
+    by a further whole number of blocks, so the engine can render a part of
+    the IR that starts later without doing work for the leading zeros.
+
+    With a slotOffset of at least one, the output for the next block only
+    depends on input that has already arrived. setWorker() then moves the
+    multiply-accumulate and inverse FFT onto a ConvolutionWorker. They run
+    during the following block, and the audio thread only does the forward
+    FFT at each block boundary. In real time the audio thread never waits
+    for the worker: a job still running at its deadline is dropped, and
+    that block goes without this segment's output. A non-real-time render
+    waits for it instead.
+
+    reset() doesn't clear the delay line. Each slot is stamped with the
+    reset it was written after, and older slots are skipped, so a job the
+    worker is still running can carry on reading them.
+*/
+class UniformConvolver
+{
+public:
+    using Lanes = juce::dsp::SIMDRegister<float>;
+
+    UniformConvolver() = default;
+
+    /** blockSize must be a power of two. */
+    void prepare (const float* impulse, int impulseLength, int blockSize, int slotOffset = 0);
+    void reset() noexcept;
+
+    /** Hands the output computation to a worker thread, or back to the audio
+        thread if worker is null. Only takes effect if slotOffset >= 1.
+    */
+    void setWorker (ConvolutionWorker* worker) noexcept;
+    bool isInBackground() const noexcept  { return worker != nullptr; }
+
+    /** When rendering faster than real time the worker is almost always
+        behind, so late jobs are waited for rather than dropped.
+    */
+    void setNonRealtime (bool isNonRealtime) noexcept { nonRealtime = isNonRealtime; }
+
+    /** Runs the queued output computation if nobody has started it yet.
+        Called by the worker, and by the audio thread when the result is due.
+    */
+    void runPendingJob() noexcept;
+
+    /** Convolves numSamples of input and adds the result to output. */
+    void process (const float* input, float* output, int numSamples) noexcept;
+
+    int getBlockSize() const noexcept    { return blockSize; }
+    int getLatency() const noexcept      { return blockSize; }
+    int getNumPartitions() const noexcept { return numPartitions; }
+
+    //==============================================================================
+    /** acc += a * b for spectra stored as numChunks registers of real parts
+        followed by numChunks registers of imaginary parts.
+    */
+    static void multiplyAccumulate (const Lanes* a, const Lanes* b, Lanes* acc, int numChunks) noexcept;
+
+private:
+    //==============================================================================
+    void processBlock() noexcept;
+    void pushInput() noexcept;
+    void collectJob() noexcept;
+    bool isReadByRunningJob (int slot) const noexcept;
+    void forgetLostSlots() noexcept;
+    void computeOutput (int newestSlot, juce::uint32 slotGeneration, float* destination) noexcept;
+    void forward (const float* timeDomain, Lanes* spectrum) noexcept;
+
+    enum JobState
+    {
+        jobIdle,
+        jobQueued,
+        jobRunning,
+        jobDone
+    };
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::FFT> jobFFT;    // the worker's own, so it never shares with the audio thread
+
+    int blockSize = 0, numBins = 0, numChunks = 0;
+    int numPartitions = 0, numSlots = 0, slotOffset = 0;
+    int currentSlot = 0, inputPosition = 0;
+
+    std::vector<Lanes> partitions;     // numPartitions spectra of the IR segment
+    std::vector<Lanes> delayLine;      // numSlots spectra of past input blocks
+    std::vector<juce::uint32> slotGenerations;  // the generation each slot was written in
+    std::vector<char> lostSlots;       // slots a late worker kept from being written
+    bool anyLostSlots = false;
+    juce::uint32 generation = 1;       // moved on by every reset()
+
+    std::vector<float> inputBuffer;    // the last two blocks of input
+    std::vector<float> outputBuffer;   // the output for the block being filled
+    std::vector<float> fftBuffer;      // for the forward transforms
+
+    // Used by computeOutput(), which runs on the worker in the background.
+    std::vector<Lanes> accumulator;
+    std::vector<float> inverseBuffer;
+
+    ConvolutionWorker* worker = nullptr;
+    bool nonRealtime = false;
+    std::atomic<int> jobState { jobIdle };
+    int jobSlot = 0;
+    juce::uint32 jobGeneration = 0;
+    std::vector<float> jobOutput;      // the worker's result for the next block
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (UniformConvolver)
+};
@@ -0,0 +1,78 @@
+#include "WavetableLFO.h"
+
+//==============================================================================
+void WavetableLFO::prepare (double sampleRate, float maxFrequency, int numWaveforms, const ShapeFunction& shape)
+{
+    if (sampleRate == tableSampleRate && maxFrequency == tableMaxFrequency && numWaveforms == getNumWaveforms())
+        return;
+
+    tableSampleRate = sampleRate;
+    tableMaxFrequency = maxFrequency;
+
+    const int order = juce::roundToInt (std::log2 ((double) tableSize));
+    juce::dsp::FFT fft (order);
+
+    // Keep every harmonic that is still below Nyquist at the fastest rate.
+    const int maxHarmonic = juce::jlimit (1, tableSize / 2 - 1,
+                                          (int) (0.5 * sampleRate / juce::jmax (1.0f, maxFrequency)));
+
+    std::vector<float> buffer ((size_t) (2 * tableSize), 0.0f);
+    tables.resize ((size_t) numWaveforms);
+
+    for (int waveform = 0; waveform < numWaveforms; ++waveform)
+    {
+        std::fill (buffer.begin(), buffer.end(), 0.0f);
+
+        for (int i = 0; i < tableSize; ++i)
+            buffer[(size_t) i] = shape ((float) i / (float) tableSize, waveform);
+
+        fft.performRealOnlyForwardTransform (buffer.data(), true);
+
+        for (int k = 1; k <= tableSize / 2; ++k)
+        {
+            auto gain = 0.0f;
+
+            if (k <= maxHarmonic)
+            {
+                const auto x = juce::MathConstants<float>::pi * (float) k / (float) (maxHarmonic + 1);
+                gain = std::sin (x) / x;
+            }
+
+            buffer[(size_t) (2 * k)]     *= gain;
+            buffer[(size_t) (2 * k + 1)] *= gain;
+        }
+
+        for (int k = tableSize / 2 + 1; k < tableSize; ++k)
+        {
+            buffer[(size_t) (2 * k)]     =  buffer[(size_t) (2 * (tableSize - k))];
+            buffer[(size_t) (2 * k + 1)] = -buffer[(size_t) (2 * (tableSize - k) + 1)];
+        }
+
+        fft.performRealOnlyInverseTransform (buffer.data());
+
+        auto& table = tables[(size_t) waveform];
+        table.assign (buffer.begin(), buffer.begin() + tableSize);
+        table.push_back (table.front());
+    }
+}
+
+void WavetableLFO::fillGainCurve (int waveform, const float* phases, float phaseOffset,
+                                  const float* depth, float* gain, int numSamples) const noexcept
+{
+    jassert (juce::isPositiveAndBelow (waveform, (int) tables.size()));
+
+    const auto* table = tables[(size_t) waveform].data();
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto phase = phases[i] + phaseOffset;
+        phase -= phase >= 1.0f ? 1.0f : 0.0f;
+
+        const auto position = phase * (float) tableSize;
+        const auto index = (int) position;
+        const auto fraction = position - (float) index;
+        const auto shape = table[index] + fraction * (table[index + 1] - table[index]);
+
+        gain[i] = 1.0f - depth[i] + depth[i] * shape;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Precomputed single-cycle tables for the tremolo LFO shapes, read with
+    linear interpolation.
+
+    Each table is sampled from a naive shape function and then band-limited
+    to the harmonics that stay below Nyquist at the fastest LFO rate. Lanczos
+    sigma factors tame the Gibbs overshoot on the hard edges. The square and
+    sawtooth shapes then no longer alias into clicks at high rates, and the
+    hot loop doesn't need any transcendental calls.
+*/
+class WavetableLFO
+{
+public:
+    enum
+    {
+        tableSize = 2048
+    };
+
+    using ShapeFunction = std::function<float (float phase, int waveform)>;
+
+    WavetableLFO() = default;
+
+    /** Builds the tables for numWaveforms shapes. Call from prepareToPlay().
+        The tables only depend on the rate and the fastest LFO, so a call
+        that changes neither keeps the ones already built.
+    */
+    void prepare (double sampleRate, float maxFrequency, int numWaveforms, const ShapeFunction& shape);
+
+    int getNumWaveforms() const noexcept { return (int) tables.size(); }
+
+    /** Fills gain with the tremolo gain 1 - depth + depth * shape, reading
+        the waveform's table at each of phases shifted by phaseOffset cycles.
+        phases must be in [0, 1) and phaseOffset in [0, 1).
+    */
+    void fillGainCurve (int waveform, const float* phases, float phaseOffset,
+                        const float* depth, float* gain, int numSamples) const noexcept;
+
+private:
+    // Each table has one guard point at the end, equal to the first.
+    std::vector<std::vector<float>> tables;
+    double tableSampleRate = 0.0;
+    float tableMaxFrequency = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableLFO)
+};
@@ -41,11 +41,28 @@ SimpleReverbAudioProcessorEditor::SimpleReverbAudioProcessorEditor (SimpleReverb
     freezeButton.setColour (juce::TextButton::textColourOnId, MyColours::blue);
     freezeButton.setColour (juce::TextButton::textColourOffId, MyColours::grey);
 
+    irButton.setButtonText ("IR");
+    irButton.setColour (juce::TextButton::buttonColourId, juce::Colours::transparentWhite);
+    irButton.setColour (juce::TextButton::textColourOffId, MyColours::grey);
+    irButton.onClick = [this]
+    {
+        irChooser = std::make_unique<juce::FileChooser> ("Load an impulse response", juce::File(), "*.wav;*.aif;*.aiff");
+        irChooser->launchAsync (juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                [this] (const juce::FileChooser& chooser)
+                                {
+                                    auto file = chooser.getResult();
+
+                                    if (file.existsAsFile())
+                                        audioProcessor.loadImpulseResponse (file);
+                                });
+    };
+
     addAndMakeVisible (sizeSlider);
     addAndMakeVisible (dampSlider);
     addAndMakeVisible (widthSlider);
     addAndMakeVisible (dwSlider);
     addAndMakeVisible (freezeButton);
+    addAndMakeVisible (irButton);
 }
 
 SimpleReverbAudioProcessorEditor::~SimpleReverbAudioProcessorEditor()
@@ -66,6 +83,7 @@ void SimpleReverbAudioProcessorEditor::resized()
     freezeButton.setBounds (240, 130, 80, 55);
     widthSlider.setBounds  (345, 130, 70, 70);
     dwSlider.setBounds     (440, 130, 70, 70);
+    irButton.setBounds     (490, 20,  50, 30);
 }
 
 
@@ -71,6 +71,8 @@ private:
                  dwSlider;
 
     juce::TextButton freezeButton;
+    juce::TextButton irButton;
+    std::unique_ptr<juce::FileChooser> irChooser;
 
     juce::AudioProcessorValueTreeState::SliderAttachment sizeSliderAttachment,
                                                          dampSliderAttachment,
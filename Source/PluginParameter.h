@@ -7,6 +7,8 @@ using Parameter = AudioProcessorValueTreeState::Parameter;
 
 //==============================================================================
 
+class PluginParameter;
+
 class PluginParametersManager
 {
 public:
@@ -14,9 +16,15 @@ public:
     {
     }
 
+    /** Hands every parameter that changed since the last call its latest
+        value. Call at the top of processBlock().
+    */
+    void processPendingUpdates() noexcept;
+
     AudioProcessorValueTreeState apvts;
     StringArray parameterTypes;
     Array<StringArray> comboBoxItemLists;
+    Array<PluginParameter*> pluginParameters;
 };
 
 //==============================================================================
@@ -31,6 +39,7 @@ protected:
         : parametersManager (parametersManager)
         , callback (callback)
     {
+        parametersManager.pluginParameters.add (this);
     }
 
 public:
@@ -42,16 +51,76 @@ public:
             setCurrentAndTargetValue (value);
     }
 
+    /** Called on whichever thread changed the parameter: the message thread,
+        or the audio thread for host automation. The APVTS has already stored
+        the new value, so this only flags it for the audio thread. It never
+        blocks, and however many changes come in, the latest one wins.
+    */
     void parameterChanged (const String& parameterID, float newValue) override
     {
-        updateValue (newValue);
+        changed.store (true, std::memory_order_release);
+    }
+
+    /** Sets the smoother's target to the latest value if it changed since
+        the last call. Audio thread only.
+    */
+    void processPendingUpdate() noexcept
+    {
+        if (changed.exchange (false, std::memory_order_acquire))
+        {
+            const float newValue = rawValue->load (std::memory_order_relaxed);
+            setTargetValue (callback != nullptr ? callback (newValue) : newValue);
+        }
+    }
+
+    /** Writes the next numSamples smoothed values into destination and moves
+        the smoother on by the same amount. The ramp is a single multiply-add
+        per sample with no dependency between samples, so it vectorises.
+    */
+    void fillRamp (float* destination, int numSamples) noexcept
+    {
+        const int numSmoothed = jmin (numSamples, countdown);
+
+        if (numSmoothed > 0)
+        {
+            const float start = currentValue;
+            const float increment = (target - currentValue) / (float) countdown;
+
+            for (int i = 0; i < numSmoothed; ++i)
+                destination[i] = start + increment * (float) (i + 1);
+        }
+
+        FloatVectorOperations::fill (destination + numSmoothed, target, numSamples - numSmoothed);
+        skip (numSamples);
     }
 
     PluginParametersManager& parametersManager;
     std::function<float (float)> callback;
     String paramID;
+
+protected:
+    /** Looks the parameter's value up once and starts listening to it. Call
+        once the parameter has been added to the APVTS.
+    */
+    void attachToState()
+    {
+        rawValue = parametersManager.apvts.getRawParameterValue (paramID);
+        jassert (rawValue != nullptr);
+
+        parametersManager.apvts.addParameterListener (paramID, this);
+    }
+
+private:
+    std::atomic<float>* rawValue = nullptr;
+    std::atomic<bool> changed { false };
 };
 
+inline void PluginParametersManager::processPendingUpdates() noexcept
+{
+    for (auto* parameter : pluginParameters)
+        parameter->processPendingUpdate();
+}
+
 //==============================================================================
 
 class PluginParameterSlider : public PluginParameter
@@ -85,7 +154,7 @@ protected:
              [](const String& text){ return text.getFloatValue(); })
         );
 
-        parametersManager.apvts.addParameterListener (paramID, this);
+        attachToState();
         updateValue (defaultValue);
     }
 
@@ -170,7 +239,7 @@ public:
              [toggleStates](const String& text){ return toggleStates.indexOf (text); })
         );
 
-        parametersManager.apvts.addParameterListener (paramID, this);
+        attachToState();
         updateValue ((float)defaultState);
     }
 
@@ -205,7 +274,7 @@ public:
              [items](const String& text){ return items.indexOf (text); })
         );
 
-        parametersManager.apvts.addParameterListener (paramID, this);
+        attachToState();
         updateValue ((float)defaultChoice);
     }
 
@@ -7,7 +7,9 @@
 */
 
 #include "PluginProcessor.h"
-#include "PluginEditor.h"
+#if ! SIMPLEREVERB_HEADLESS
+ #include "PluginEditor.h"
+#endif
 #include "PluginParameter.h"
 
 //==============================================================================
@@ -26,14 +28,24 @@ SimpleReverbAudioProcessor::SimpleReverbAudioProcessor()
     , paramDepth (parameters, "Depth", "", 0.0f, 1.0f, 0.5f)
     , paramFrequency (parameters, "LFO Frequency", "Hz", 0.0f, 10.0f, 2.0f)
     , paramWaveform (parameters, "LFO Waveform", waveformItemsUI, waveformSine)
+    , paramStereoPhase (parameters, "LFO Stereo Phase", "deg", 0.0f, 180.0f, 0.0f,
+                        [](float value){ return value / 360.0f; })
 {
     parameters.apvts.state = ValueTree (Identifier (getName().removeCharacters ("- ")));
+
+    for (int i = 0; i < numReverbParameters; ++i)
+        reverbParameters[i] = apvts.getRawParameterValue (reverbParameterIDs[i]);
 }
 
 SimpleReverbAudioProcessor::~SimpleReverbAudioProcessor()
 {
+    impulseLoader.removeAllJobs (true, -1);
 }
 
+const char* const SimpleReverbAudioProcessor::reverbParameterIDs[] = {
+    "size", "damp", "width", "dry/wet", "freeze", "algorithm"
+};
+
 //==============================================================================
 const juce::String SimpleReverbAudioProcessor::getName() const
 {
@@ -69,7 +81,17 @@ bool SimpleReverbAudioProcessor::isMidiEffect() const
 
 double SimpleReverbAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Hosts ask from the message thread, so this can't touch the scheduled
+    // values the audio thread owns.
+    const auto snapshot = readParameters();
+
+    if (snapshot.algorithm == algorithmConvolution)
+        return convolutionReverb.getTailLengthSeconds();
+
+    if (snapshot.algorithm == algorithmFDN)
+        return FDNReverb::getTailLengthSeconds (snapshot.toReverbParameters());
+
+    return ReverbEngine::getTailLengthSeconds (snapshot.toReverbParameters());
 }
 
 int SimpleReverbAudioProcessor::getNumPrograms()
@@ -101,28 +123,72 @@ void SimpleReverbAudioProcessor::prepareToPlay (double sampleRate, int samplesPe
 {
     juce::dsp::ProcessSpec spec;
 
+    // The LFE channel only ever carries the dry signal, so the engines
+    // neither see it nor spend a tail on it.
+    lfeChannel = getChannelLayoutOfBus (false, 0).getChannelIndexForType (juce::AudioChannelSet::LFE);
+
+    const int numProcessedChannels = isMonoToStereo() ? getTotalNumOutputChannels() : getTotalNumInputChannels();
+
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = (juce::uint32) (numProcessedChannels - (isPositiveAndBelow (lfeChannel, numProcessedChannels) ? 1 : 0));
+
+    const bool monoInput = isMonoToStereo();
+
+    // A host that processes in double gets the FDN lines in double too, so
+    // a frozen tank holds its tail without float rounding.
+    const bool doublePrecision = isUsingDoublePrecision();
+
+    // Every delay line of both tanks comes from one block, freed in
+    // releaseResources(). If only the block size changed, the arena and the
+    // convolution engine are kept rather than built again.
+    delayArena.allocate (ReverbEngine::getArenaSize (spec, monoInput) + FDNReverb::getArenaSize (spec, doublePrecision));
+    reverb.prepare (spec, delayArena, monoInput);
+    fdnReverb.prepare (spec, delayArena, monoInput, doublePrecision);
+    convolutionReverb.setNonRealtime (isNonRealtime());
+    convolutionReverb.prepare (spec, monoInput);
+    parametersDirty = true;
+    reverbIdle = false;
+    quietSamples = 0;
+
+    // Scheduled changes belong to the render that queued them.
+    scheduler.clear();
+
+    for (auto& scheduled : scheduledValues)
+        scheduled.active = false;
 
-    leftReverb.prepare(spec);
-    rightReverb.prepare(spec);
     const double smoothTime = 1e-3;
     paramDepth.reset (sampleRate, smoothTime);
     paramFrequency.reset (sampleRate, smoothTime);
     paramWaveform.reset (sampleRate, smoothTime);
+    paramStereoPhase.reset (sampleRate, smoothTime);
 
     //======================================
 
-    lfoPhase = 0.0f;
+    depthRamp.resize ((size_t) samplesPerBlock);
+    frequencyRamp.resize ((size_t) samplesPerBlock);
+    phaseRamp.resize ((size_t) samplesPerBlock);
+    gainRamp.resize ((size_t) samplesPerBlock);
+
+    lfoPhase = 0.0;
     inverseSampleRate = 1.0f / (float)sampleRate;
     twoPi = 2.0f * M_PI;
+
+    // The band limit depends on the rate, so the tables are only built
+    // again, with a fresh FFT, when the rate has changed.
+    lfoTables.prepare (sampleRate, paramFrequency.maxValue, paramWaveform.items.size(),
+                       [this] (float phase, int waveform) { return lfo (phase, waveform); });
 }
 
 void SimpleReverbAudioProcessor::releaseResources()
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    // Deactivated instances keep none of their delay or convolution memory.
+    // The engines drop their pointers into the arena before it goes, and
+    // pass audio through dry until prepareToPlay() hands them a new one.
+    reverb.release();
+    fdnReverb.release();
+    convolutionReverb.release();
+    delayArena.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -132,17 +198,26 @@ bool SimpleReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Every engine runs all the channels through one shared tank, so the
+    // immersive layouts cost one reverb rather than a stack of stereo ones.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output != juce::AudioChannelSet::mono()
+     && output != juce::AudioChannelSet::stereo()
+     && output != juce::AudioChannelSet::create5point1()
+     && output != juce::AudioChannelSet::create7point1()
+     && output != juce::AudioChannelSet::create7point1point4())
         return false;
 
-    // This checks if the input layout matches the output layout
+    // The input has to match the output, except that a mono input can feed
+    // a stereo output.
    #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+    const auto& input = layouts.getMainInputChannelSet();
+
+    if (input != output
+     && ! (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo()))
         return false;
    #endif
 
@@ -152,8 +227,21 @@ bool SimpleReverbAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
 #endif
 
 void SimpleReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer);
+}
+
+void SimpleReverbAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer);
+}
+
+template <typename SampleType>
+void SimpleReverbAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
+    parameters.processPendingUpdates();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -161,61 +249,271 @@ void SimpleReverbAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         buffer.clear (i, 0, buffer.getNumSamples());
     const int numSamples = buffer.getNumSamples();
 
-    params.roomSize   = *apvts.getRawParameterValue ("size");
-    params.damping    = *apvts.getRawParameterValue ("damp");
-    params.width      = *apvts.getRawParameterValue ("width");
-    params.wetLevel   = *apvts.getRawParameterValue ("dry/wet");
-    params.dryLevel   = 1.0f - *apvts.getRawParameterValue ("dry/wet");
-    params.freezeMode = *apvts.getRawParameterValue ("freeze");
+    const int numProcessedChannels = isMonoToStereo() ? totalNumOutputChannels : totalNumInputChannels;
+
+    // Every channel but the LFE goes through the reverb.
+    SampleType* reverbChannels[ReverbEngine::getMaxNumChannels()];
+    int numReverbChannels = 0;
 
-    leftReverb.setParameters  (params);
-    rightReverb.setParameters (params);
+    for (int channel = 0; channel < numProcessedChannels; ++channel)
+        if (channel != lfeChannel && numReverbChannels < ReverbEngine::getMaxNumChannels())
+            reverbChannels[numReverbChannels++] = buffer.getWritePointer (channel);
 
-    juce::dsp::AudioBlock<float> block (buffer);
+    juce::dsp::AudioBlock<SampleType> reverbBlock (reverbChannels, (size_t) numReverbChannels, (size_t) numSamples);
 
-    auto leftBlock  = block.getSingleChannelBlock (0);
-    auto rightBlock = block.getSingleChannelBlock (1);
+    const auto silenceThreshold = (SampleType) 1.0e-6; // -120 dB
+    bool inputSilent = true;
 
-    juce::dsp::ProcessContextReplacing<float> leftContext  (leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext (rightBlock);
+    for (int channel = 0; channel < totalNumInputChannels && inputSilent; ++channel)
+        inputSilent = buffer.getMagnitude (channel, 0, numSamples) < silenceThreshold;
+
+    if (! inputSilent) {
+        reverbIdle = false;
+        quietSamples = 0;
+    }
+
+    tankLevel = 0.0f;
+
+    // Scheduled parameter changes split the block, so each one takes effect
+    // on its own sample rather than at the start of the block.
+    scheduler.process (numSamples,
+                       [this] (const SubBlockScheduler::Event& event)
+                       {
+                           auto& scheduled = scheduledValues[event.parameterIndex];
+                           scheduled.value = event.value;
+                           scheduled.parameterValue = reverbParameters[event.parameterIndex]->load (std::memory_order_relaxed);
+                           scheduled.active = true;
+                       },
+                       [this, &reverbBlock] (int startSample, int numSegmentSamples)
+                       {
+                           if (! reverbIdle)
+                               processReverb (reverbBlock.getSubBlock ((size_t) startSample, (size_t) numSegmentSamples));
+                       });
+
+    // The tail only counts as gone once the engine's own tank has stayed
+    // quiet for longer than its longest internal delay, or the whole IR. The
+    // mixed output can't tell, as the wet level may be zero. A frozen tank
+    // never goes idle.
+    if (inputSilent && ! reverbIdle) {
+        const int requiredQuietSamples = currentAlgorithm == algorithmConvolution
+                                           ? jmax (1, convolutionReverb.getTailLengthSamples())
+                                           : (int) (0.1f / inverseSampleRate);
+
+        const bool frozen = params.freezeMode >= 0.5f;
+
+        quietSamples = tankLevel < (float) silenceThreshold && ! frozen ? quietSamples + numSamples : 0;
+        reverbIdle = quietSamples >= requiredQuietSamples;
+    }
 
-    leftReverb.process  (leftContext);
-    rightReverb.process (rightContext);
     //======================================
 
-    float currentDepth = paramDepth.getNextValue();
-    float currentFrequency = paramFrequency.getNextValue();
-    float phase;
+    if (reverbIdle) {
+        // Nothing to modulate. Keep the smoothers and the LFO moving so the
+        // tremolo carries on where it would have been.
+        paramDepth.skip (numSamples);
+        paramFrequency.skip (numSamples);
+
+        lfoPhase += (double) (paramFrequency.getTargetValue() * inverseSampleRate) * numSamples;
+        lfoPhase -= std::floor (lfoPhase);
+        return;
+    }
+
+    // Depth and frequency are smoothed per sample, a ramp buffer at a time.
+    // The ramps are sized in prepareToPlay(), so there's nothing to do before it.
+    const int rampSize = (int) depthRamp.size();
+    jassert (rampSize > 0);
+
+    if (rampSize == 0)
+        return;
+
+    // The waveform is picked once per block. Every shape is read from its
+    // band-limited table, so the same kernel serves them all.
+    const int waveform = jlimit (0, lfoTables.getNumWaveforms() - 1,
+                                 (int)paramWaveform.getTargetValue());
+    const float channelPhaseOffset = paramStereoPhase.getTargetValue();
+
+    for (int start = 0; start < numSamples; start += rampSize) {
+        const int numToDo = jmin (rampSize, numSamples - start);
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel) {
-        float* channelData = buffer.getWritePointer (channel);
-        phase = lfoPhase;
+        paramDepth.fillRamp (depthRamp.data(), numToDo);
+        paramFrequency.fillRamp (frequencyRamp.data(), numToDo);
 
-        for (int sample = 0; sample < numSamples; ++sample) {
-            const float in = channelData[sample];
-            float modulation = lfo (phase, (int)paramWaveform.getTargetValue());
-            float out = in * (1 - currentDepth + currentDepth * modulation);
+        // One phase accumulator drives every channel.
+        double phase = lfoPhase;
 
-            channelData[sample] = out;
+        for (int sample = 0; sample < numToDo; ++sample) {
+            phaseRamp[(size_t) sample] = (float) phase;
 
-            phase += currentFrequency * inverseSampleRate;
-            if (phase >= 1.0f)
-                phase -= 1.0f;
+            phase += (double) (frequencyRamp[(size_t) sample] * inverseSampleRate);
+            phase -= phase >= 1.0 ? 1.0 : 0.0;
         }
-    }
 
-    lfoPhase = phase;
+        lfoPhase = phase;
+
+        applyTremolo (buffer, start, numProcessedChannels, numToDo, waveform, channelPhaseOffset);
+    }
 
     //======================================
 
-    for (int channel = totalNumInputChannels; channel < totalNumOutputChannels; ++channel)
+    for (int channel = numProcessedChannels; channel < totalNumOutputChannels; ++channel)
         buffer.clear (channel, 0, numSamples);
 }
 
+template <typename SampleType>
+void SimpleReverbAudioProcessor::processReverb (juce::dsp::AudioBlock<SampleType> block)
+{
+    const auto snapshot = takeParameterSnapshot();
+    const int algorithm = snapshot.algorithm;
+
+    if (snapshot != lastSnapshot)
+    {
+        lastSnapshot = snapshot;
+        parametersDirty = true;
+    }
+
+    // Don't let a stale tail from the last time this engine ran leak back in.
+    // The engine also missed any parameter changes while it was idle.
+    if (algorithm != currentAlgorithm)
+    {
+        if (algorithm == algorithmFDN)
+            fdnReverb.reset();
+        else if (algorithm == algorithmConvolution)
+            convolutionReverb.reset();
+        else
+            reverb.reset();
+
+        currentAlgorithm = algorithm;
+        parametersDirty = true;
+    }
+
+    if (parametersDirty)
+        params = snapshot.toReverbParameters();
+
+    juce::dsp::ProcessContextReplacing<SampleType> context (block);
+
+    if (algorithm == algorithmFDN)
+    {
+        if (parametersDirty)
+            fdnReverb.setParameters (params);
+
+        fdnReverb.process (context);
+        tankLevel = jmax (tankLevel, fdnReverb.getTankLevel());
+    }
+    else if (algorithm == algorithmConvolution)
+    {
+        if (parametersDirty)
+            convolutionReverb.setParameters (params);
+
+        convolutionReverb.process (context);
+        tankLevel = jmax (tankLevel, convolutionReverb.getTankLevel());
+    }
+    else
+    {
+        if (parametersDirty)
+            reverb.setParameters (params);
+
+        reverb.process (context);
+        tankLevel = jmax (tankLevel, reverb.getTankLevel());
+    }
+
+    parametersDirty = false;
+}
+
+int SimpleReverbAudioProcessor::getSchedulableParameterIndex (const juce::String& parameterID)
+{
+    for (int i = 0; i < numReverbParameters; ++i)
+        if (parameterID == reverbParameterIDs[i])
+            return i;
+
+    return -1;
+}
+
+bool SimpleReverbAudioProcessor::scheduleParameterChange (int sampleOffset, int parameterIndex, float value) noexcept
+{
+    jassert (isPositiveAndBelow (parameterIndex, (int) numReverbParameters));
+    return scheduler.addEvent (sampleOffset, parameterIndex, value);
+}
+
+void SimpleReverbAudioProcessor::setTremoloPosition (juce::int64 samplePosition) noexcept
+{
+    // The same per-sample increment that processBlock() adds up.
+    const auto phase = (double) (paramFrequency.getTargetValue() * inverseSampleRate) * (double) samplePosition;
+    lfoPhase = phase - std::floor (phase);
+}
+
+SimpleReverbAudioProcessor::ParameterSnapshot SimpleReverbAudioProcessor::takeParameterSnapshot() noexcept
+{
+    ParameterSnapshot snapshot;
+
+    snapshot.roomSize  = getReverbParameterValue (reverbSize);
+    snapshot.damping   = getReverbParameterValue (reverbDamp);
+    snapshot.width     = getReverbParameterValue (reverbWidth);
+    snapshot.dryWet    = getReverbParameterValue (reverbDryWet);
+    snapshot.freeze    = getReverbParameterValue (reverbFreeze);
+    snapshot.algorithm = (int) getReverbParameterValue (reverbAlgorithm);
+
+    return snapshot;
+}
+
+SimpleReverbAudioProcessor::ParameterSnapshot SimpleReverbAudioProcessor::readParameters() const noexcept
+{
+    const auto read = [this] (int index) { return reverbParameters[index]->load (std::memory_order_relaxed); };
+
+    ParameterSnapshot snapshot;
+
+    snapshot.roomSize  = read (reverbSize);
+    snapshot.damping   = read (reverbDamp);
+    snapshot.width     = read (reverbWidth);
+    snapshot.dryWet    = read (reverbDryWet);
+    snapshot.freeze    = read (reverbFreeze);
+    snapshot.algorithm = (int) read (reverbAlgorithm);
+
+    return snapshot;
+}
+
+float SimpleReverbAudioProcessor::getReverbParameterValue (int index) noexcept
+{
+    const auto value = reverbParameters[index]->load (std::memory_order_relaxed);
+    auto& scheduled = scheduledValues[index];
+
+    // The host, or the editor, moving the parameter takes over from a
+    // scheduled value.
+    if (scheduled.active && value != scheduled.parameterValue)
+        scheduled.active = false;
+
+    return scheduled.active ? scheduled.value : value;
+}
+
 //==============================================================================
+template <typename SampleType>
+void SimpleReverbAudioProcessor::applyTremolo (AudioBuffer<SampleType>& buffer, int startSample, int numChannels,
+                                               int numSamples, int waveform, float channelPhaseOffset) noexcept
+{
+    const float* gain = gainRamp.data();
+
+    // Without an offset all the channels share one gain curve, so it's only
+    // worked out for the first and then reused.
+    const int numCurves = channelPhaseOffset > 0.0f ? numChannels : jmin (1, numChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        if (channel < numCurves) {
+            float offset = channelPhaseOffset * (float) channel;
+            offset -= std::floor (offset);
+
+            lfoTables.fillGainCurve (waveform, phaseRamp.data(), offset, depthRamp.data(),
+                                     gainRamp.data(), numSamples);
+        }
+
+        SampleType* channelData = buffer.getWritePointer (channel, startSample);
+
+        for (int sample = 0; sample < numSamples; ++sample)
+            channelData[sample] *= (SampleType) gain[sample];
+    }
+}
+
 //==============================================================================
 
-float TremoloAudioProcessor::lfo (float phase, int waveform)
+float SimpleReverbAudioProcessor::lfo (float phase, int waveform)
 {
     float out = 0.0f;
 
@@ -272,37 +570,142 @@ float TremoloAudioProcessor::lfo (float phase, int waveform)
 
 //==============================================================================
 
+// The command-line tools build the processor with SIMPLEREVERB_HEADLESS,
+// so they don't need the editor or its resources.
 bool SimpleReverbAudioProcessor::hasEditor() const
 {
+   #if SIMPLEREVERB_HEADLESS
+    return false;
+   #else
     return true; // (change this to false if you choose to not supply an editor)
+   #endif
 }
 
 juce::AudioProcessorEditor* SimpleReverbAudioProcessor::createEditor()
 {
+   #if SIMPLEREVERB_HEADLESS
+    return nullptr;
+   #else
     return new SimpleReverbAudioProcessorEditor (*this);
+   #endif
 }
 
 //==============================================================================
 void SimpleReverbAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    juce::MemoryOutputStream mos (destData, true);
-    apvts.state.writeToStream (mos);
-    auto state = parameters.apvts.copyState();
+    // Both trees go into one document. Writing them one after the other
+    // into destData would leave only the second.
+    juce::ValueTree state ("SimpleReverbState");
+    state.appendChild (apvts.copyState(), nullptr);
+    state.appendChild (parameters.apvts.copyState(), nullptr);
+
     std::unique_ptr<XmlElement> xml (state.createXml());
     copyXmlToBinary (*xml, destData);
 }
 
 void SimpleReverbAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    auto tree = juce::ValueTree::readFromData (data, sizeInBytes);
-
-    if (tree.isValid())
-        apvts.replaceState (tree);
     std::unique_ptr<XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
-    if (xmlState.get() != nullptr)
-        if (xmlState->hasTagName (parameters.apvts.state.getType()))
-            parameters.apvts.replaceState (ValueTree::fromXml (*xmlState));
+    if (xmlState.get() == nullptr)
+        return;
+
+    auto state = ValueTree::fromXml (*xmlState);
+
+    if (state.hasType (parameters.apvts.state.getType()))
+    {
+        // Older sessions only kept the tremolo parameters, and no IR.
+        parameters.apvts.replaceState (state);
+        apvts.state.removeProperty ("irPath", nullptr);
+    }
+    else
+    {
+        auto reverbState  = state.getChildWithName (apvts.state.getType());
+        auto tremoloState = state.getChildWithName (parameters.apvts.state.getType());
+
+        if (reverbState.isValid())
+            apvts.replaceState (reverbState);
+
+        if (tremoloState.isValid())
+            parameters.apvts.replaceState (tremoloState);
+    }
+
+    restoreImpulseResponse();
+}
+
+//==============================================================================
+bool SimpleReverbAudioProcessor::readImpulseResponse (const juce::File& file, juce::AudioBuffer<float>& impulse, double& sampleRate)
+{
+    const double maxImpulseSeconds = 20.0;
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+    if (reader == nullptr)
+        return false;
+
+    const auto length = (int) juce::jmin (reader->lengthInSamples,
+                                          (juce::int64) (reader->sampleRate * maxImpulseSeconds));
+
+    impulse.setSize ((int) reader->numChannels, length);
+    reader->read (&impulse, 0, length, 0, true, true);
+    sampleRate = reader->sampleRate;
+
+    return true;
+}
+
+bool SimpleReverbAudioProcessor::loadImpulseResponse (const juce::File& file)
+{
+    // A load still running for a restored state would land on top of this.
+    impulseLoader.removeAllJobs (true, -1);
+
+    juce::AudioBuffer<float> impulse;
+    double sampleRate = 0.0;
+
+    if (! readImpulseResponse (file, impulse, sampleRate))
+        return false;
+
+    convolutionReverb.loadImpulseResponse (std::move (impulse), sampleRate);
+    apvts.state.setProperty ("irPath", file.getFullPathName(), nullptr);
+
+    return true;
+}
+
+void SimpleReverbAudioProcessor::restoreImpulseResponse()
+{
+    impulseLoader.removeAllJobs (true, -1);
+
+    // Whatever was loaded before belongs to another session, so it goes
+    // even when this one has no IR, or its IR has since been moved.
+    convolutionReverb.clearImpulseResponse();
+
+    const auto irPath = apvts.state.getProperty ("irPath").toString();
+
+    if (! juce::File::isAbsolutePath (irPath) || ! juce::File (irPath).existsAsFile())
+    {
+        apvts.state.removeProperty ("irPath", nullptr);
+        return;
+    }
+
+    // Reading and resampling the IR is left to the loader, so that hosts
+    // restoring a session don't wait on it. The convolution runs dry until
+    // it's in place.
+    impulseLoader.addJob ([this, file = juce::File (irPath)]
+                          {
+                              juce::AudioBuffer<float> impulse;
+                              double sampleRate = 0.0;
+
+                              if (readImpulseResponse (file, impulse, sampleRate))
+                                  convolutionReverb.loadImpulseResponse (std::move (impulse), sampleRate);
+                          });
+}
+
+void SimpleReverbAudioProcessor::waitForImpulseResponse()
+{
+    while (impulseLoader.getNumJobs() > 0)
+        juce::Thread::sleep (1);
 }
 
 //==============================================================================
@@ -383,5 +786,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleReverbAudioProcessor::
 
     layout.add (std::make_unique<juce::AudioParameterBool> ("freeze", "freeze", false));
 
+    layout.add (std::make_unique<juce::AudioParameterChoice> ("algorithm",
+                                                              "algorithm",
+                                                              juce::StringArray { "Freeverb", "FDN", "Convolution" },
+                                                              algorithmFreeverb));
+
     return layout;
 }
@@ -10,6 +10,12 @@
 
 #include <JuceHeader.h>
 #include "PluginParameter.h"
+#include "DSP/ReverbEngine.h"
+#include "DSP/FDNReverb.h"
+#include "DSP/ConvolutionReverb.h"
+#include "DSP/DelayArena.h"
+#include "DSP/WavetableLFO.h"
+#include "DSP/SubBlockScheduler.h"
 #define _USE_MATH_DEFINES
 #include <cmath>
 
@@ -32,6 +38,9 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -69,6 +78,59 @@ public:
         "Square with sloped edges"
     };
 
+    enum algorithmIndex {
+        algorithmFreeverb = 0,
+        algorithmFDN,
+        algorithmConvolution,
+    };
+
+    /** Loads an impulse response for the convolution algorithm and remembers
+        its path in the state. Returns false if the file can't be read.
+    */
+    bool loadImpulseResponse (const juce::File& file);
+
+    /** Waits for the impulse response that setStateInformation() started
+        loading in the background, for callers that render straight after
+        restoring a state.
+    */
+    void waitForImpulseResponse();
+
+    /** The reverb parameters, as scheduleParameterChange() numbers them. */
+    enum reverbParameterIndex {
+        reverbSize = 0,
+        reverbDamp,
+        reverbWidth,
+        reverbDryWet,
+        reverbFreeze,
+        reverbAlgorithm,
+        numReverbParameters
+    };
+
+    /** The reverbParameterIndex of a parameter ID, or -1 if the parameter
+        can't be scheduled. Look this up once, before rendering.
+    */
+    static int getSchedulableParameterIndex (const juce::String& parameterID);
+
+    /** Queues a change to one of the reverb parameters that lands sampleOffset
+        samples into the next processBlock() call, for callers that know the
+        exact timing of their automation, such as an offline render. value is
+        in the parameter's own range.
+
+        The value goes straight to the engines and isn't sent to the host. It
+        holds until the parameter itself next changes. Call this from the
+        thread that calls processBlock(). Returns false if the queue is full.
+    */
+    bool scheduleParameterChange (int sampleOffset, int parameterIndex, float value) noexcept;
+
+    /** Scheduled changes closer together than this are merged. */
+    void setMinimumSubBlockSize (int numSamples) noexcept { scheduler.setMinimumSubBlockSize (numSamples); }
+
+    /** Moves the tremolo to where it would be samplePosition samples after
+        prepareToPlay(), at the current LFO rate. Lets an offline render start
+        part way through a file. Call this between blocks.
+    */
+    void setTremoloPosition (juce::int64 samplePosition) noexcept;
+
     enum waveformIndex {
         waveformSine = 0,
         waveformTriangle,
@@ -80,12 +142,12 @@ public:
 
     //======================================
 
-    float lfoPhase;
+    // Accumulated in double, so a render hours long still lands where
+    // setTremoloPosition() puts it.
+    double lfoPhase;
     float inverseSampleRate;
     float twoPi;
 
-    float lfo (float phase, int waveform);
-
     //======================================
 
     PluginParametersManager parameters;
@@ -93,10 +155,127 @@ public:
     PluginParameterLinSlider paramDepth;
     PluginParameterLinSlider paramFrequency;
     PluginParameterComboBox paramWaveform;
+    PluginParameterLinSlider paramStereoPhase;
 
 private:
-    juce::dsp::Reverb::Parameters params;
-    juce::dsp::Reverb leftReverb, rightReverb; 
+    //==============================================================================
+    /** Plain copy of the reverb parameters, taken once at the top of each sub-block. */
+    struct ParameterSnapshot
+    {
+        float roomSize = 0.0f, damping = 0.0f, width = 0.0f, dryWet = 0.0f, freeze = 0.0f;
+        int algorithm = algorithmFreeverb;
+
+        bool operator== (const ParameterSnapshot& other) const noexcept
+        {
+            return roomSize == other.roomSize && damping == other.damping && width == other.width
+                && dryWet == other.dryWet && freeze == other.freeze && algorithm == other.algorithm;
+        }
+
+        bool operator!= (const ParameterSnapshot& other) const noexcept { return ! operator== (other); }
+
+        ReverbEngine::Parameters toReverbParameters() const noexcept
+        {
+            ReverbEngine::Parameters p;
+            p.roomSize   = roomSize;
+            p.damping    = damping;
+            p.width      = width;
+            p.wetLevel   = dryWet;
+            p.dryLevel   = 1.0f - dryWet;
+            p.freezeMode = freeze;
+            return p;
+        }
+    };
+
+    /** Reads the reverb parameters, with any scheduled values in place of
+        the parameters' own. Only call this from the audio thread, as it
+        drops scheduled values that the parameters have overtaken.
+    */
+    ParameterSnapshot takeParameterSnapshot() noexcept;
+    float getReverbParameterValue (int index) noexcept;
+
+    /** Reads the parameters' own values, ignoring anything scheduled. Safe
+        from any thread.
+    */
+    ParameterSnapshot readParameters() const noexcept;
+
+    /** A mono input feeding a stereo output. The engines then read channel 0
+        only and write a decorrelated tail to both channels.
+    */
+    bool isMonoToStereo() const noexcept { return getTotalNumInputChannels() == 1 && getTotalNumOutputChannels() == 2; }
+
+    /** Runs the selected reverb over one sub-block with the current parameters. */
+    template <typename SampleType>
+    void processReverb (juce::dsp::AudioBlock<SampleType> block);
+
+    /** The body of both processBlock() overloads. */
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer);
+
+    std::vector<float> depthRamp;
+    std::vector<float> frequencyRamp;
+    std::vector<float> phaseRamp;
+    std::vector<float> gainRamp;
+
+    /** The naive LFO shapes. Only used to build lfoTables, which are the
+        only thing the tremolo reads.
+    */
+    float lfo (float phase, int waveform);
+    WavetableLFO lfoTables;
+
+    /** Applies the tremolo to numChannels channels of buffer, from startSample,
+        following the phases already in phaseRamp and the waveform's table.
+        Channel n is shifted by n times channelPhaseOffset, in cycles.
+    */
+    template <typename SampleType>
+    void applyTremolo (AudioBuffer<SampleType>& buffer, int startSample, int numChannels,
+                       int numSamples, int waveform, float channelPhaseOffset) noexcept;
+
+    static const char* const reverbParameterIDs[numReverbParameters];
+    std::atomic<float>* reverbParameters[numReverbParameters] = {};
+
+    /** A value scheduleParameterChange() put in place of a parameter's own,
+        and the parameter's value at the time, so that it's dropped as soon
+        as the parameter moves.
+    */
+    struct ScheduledValue
+    {
+        float value = 0.0f;
+        float parameterValue = 0.0f;
+        bool active = false;
+    };
+
+    ScheduledValue scheduledValues[numReverbParameters];
+
+    static bool readImpulseResponse (const juce::File& file, juce::AudioBuffer<float>& impulse, double& sampleRate);
+    void restoreImpulseResponse();
+
+    ParameterSnapshot lastSnapshot;
+    bool parametersDirty = true;
+
+    ReverbEngine::Parameters params;
+    DelayArena delayArena;
+    ReverbEngine reverb;
+    FDNReverb fdnReverb;
+    ConvolutionReverb convolutionReverb;
+    int currentAlgorithm = algorithmFreeverb;
+
+    SubBlockScheduler scheduler;
+
+    // The output's LFE channel, which the reverb leaves alone, or -1.
+    int lfeChannel = -1;
+
+    // Set once the input is silent and the tail has decayed below -120 dB.
+    // The engines are skipped until the input comes back.
+    bool reverbIdle = false;
+    int quietSamples = 0;
+
+    // The loudest the running engine's tank got this block, whatever the
+    // wet level.
+    float tankLevel = 0.0f;
+
+    // Reads and resamples the impulse response of a restored state, which
+    // can take a while for a long one. Declared last so it stops first.
+    juce::ThreadPool impulseLoader { 1 };
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleReverbAudioProcessor)
 };
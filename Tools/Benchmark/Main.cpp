@@ -0,0 +1,557 @@
+/*
+  ==============================================================================
+
+    SimpleReverbBenchmark: times the plugin's processBlock() across block
+    sizes, sample rates, channel layouts, algorithms, freeze and tremolo
+    waveforms, and the tremolo's gain kernel on its own, and writes the
+    results as JSON.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+#include <iostream>
+
+//==============================================================================
+namespace
+{
+    void printUsage()
+    {
+        std::cerr << "Usage: SimpleReverbBenchmark [options]\n"
+                     "\n"
+                     "Options:\n"
+                     "  --block-sizes <list>   Comma-separated block sizes (default 16 to 4096 in octaves)\n"
+                     "  --sample-rates <list>  Comma-separated rates in Hz (default 44100 to 192000)\n"
+                     "  --layouts <list>       Any of mono, stereo, 5.1, 7.1, 7.1.4 (default all)\n"
+                     "  --algorithms <list>    Any of Freeverb, FDN, Convolution (default all)\n"
+                     "  --ir <file>            Impulse response for Convolution (default: 2 s of\n"
+                     "                         decaying stereo noise)\n"
+                     "  --seconds <n>          Audio timed per case (default 0.5)\n"
+                     "  --quick                Stereo at 48 kHz, with blocks of 64, 512 and 4096 only\n"
+                     "  --output <file>        Writes the JSON to a file rather than stdout\n"
+                     "\n"
+                     "Every combination is timed with freeze off and on, and with each LFO\n"
+                     "waveform. The tremolo's gain kernel is also timed on its own at each\n"
+                     "block size, against the per-sample shape call it replaced. Progress\n"
+                     "goes to stderr.\n";
+    }
+
+    /** Long enough that the reverb never settles into a repeating pattern. */
+    const int noiseLength = 65536;
+
+    /** What to time. Every combination of these is one case. */
+    struct Sweep
+    {
+        juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        juce::StringArray layouts { "mono", "stereo", "5.1", "7.1", "7.1.4" };
+        juce::StringArray algorithms { "Freeverb", "FDN", "Convolution" };
+        double seconds = 0.5;
+        juce::File impulseResponse, output;
+    };
+
+    juce::AudioChannelSet getChannelSet (const juce::String& layout)
+    {
+        if (layout == "mono")    return juce::AudioChannelSet::mono();
+        if (layout == "stereo")  return juce::AudioChannelSet::stereo();
+        if (layout == "5.1")     return juce::AudioChannelSet::create5point1();
+        if (layout == "7.1")     return juce::AudioChannelSet::create7point1();
+        if (layout == "7.1.4")   return juce::AudioChannelSet::create7point1point4();
+
+        return {};
+    }
+
+    juce::Result parseArguments (const juce::StringArray& args, Sweep& sweep)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+            const auto value = i + 1 < args.size() ? args[i + 1] : juce::String();
+            const auto list = juce::StringArray::fromTokens (value, ",", "");
+
+            if (arg == "--quick")
+            {
+                sweep.blockSizes = { 64, 512, 4096 };
+                sweep.sampleRates = { 48000.0 };
+                sweep.layouts = { "stereo" };
+                continue;
+            }
+
+            if (value.isEmpty())
+                return juce::Result::fail (arg.startsWith ("--") ? arg + " needs a value" : "Unknown argument " + arg);
+
+            ++i;
+
+            if (arg == "--block-sizes")
+            {
+                sweep.blockSizes.clear();
+
+                for (auto& item : list)
+                {
+                    if (item.getIntValue() <= 0 || item.getIntValue() > noiseLength)
+                        return juce::Result::fail ("Block sizes have to be between 1 and " + juce::String (noiseLength) + " samples");
+
+                    sweep.blockSizes.add (item.getIntValue());
+                }
+            }
+            else if (arg == "--sample-rates")
+            {
+                sweep.sampleRates.clear();
+
+                for (auto& item : list)
+                {
+                    if (item.getDoubleValue() <= 0.0)
+                        return juce::Result::fail ("Sample rates have to be above 0 Hz");
+
+                    sweep.sampleRates.add (item.getDoubleValue());
+                }
+            }
+            else if (arg == "--layouts")
+            {
+                for (auto& item : list)
+                    if (getChannelSet (item).isDisabled())
+                        return juce::Result::fail ("There's no layout called " + item);
+
+                sweep.layouts = list;
+            }
+            else if (arg == "--algorithms")
+            {
+                sweep.algorithms = list;
+            }
+            else if (arg == "--seconds")
+            {
+                if (value.getDoubleValue() <= 0.0)
+                    return juce::Result::fail ("--seconds needs a length of audio");
+
+                sweep.seconds = value.getDoubleValue();
+            }
+            else if (arg == "--output" || arg == "--ir")
+            {
+                (arg == "--output" ? sweep.output : sweep.impulseResponse)
+                    = juce::File::getCurrentWorkingDirectory().getChildFile (value.unquoted());
+            }
+            else
+            {
+                return juce::Result::fail ("Unknown option " + arg);
+            }
+        }
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    /** Sets a parameter from text, as the host would from a typed-in value. */
+    void setParameter (juce::AudioProcessor& processor, const juce::String& parameterID, const juce::String& text)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                if (withID->paramID == parameterID)
+                    withID->setValueNotifyingHost (withID->getValueForText (text));
+    }
+
+    struct Measurement
+    {
+        juce::int64 numSamples = 0;
+        int numBlocks = 0;
+        double totalSeconds = 0.0;
+        double worstBlockSeconds = 0.0;
+    };
+
+    /** Prepares the processor and times blocks of noise through it. Only the
+        processBlock() calls are timed, not refilling the buffer.
+    */
+    Measurement measure (SimpleReverbAudioProcessor& processor, double sampleRate, int blockSize,
+                         double seconds, const juce::AudioBuffer<float>& noise)
+    {
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        const auto numInputChannels = processor.getTotalNumInputChannels();
+        const auto numNoiseOffsets = noise.getNumSamples() - blockSize + 1;
+
+        juce::AudioBuffer<float> buffer (juce::jmax (numInputChannels, processor.getTotalNumOutputChannels()), blockSize);
+        juce::MidiBuffer midi;
+
+        auto processNextBlock = [&] (int blockIndex)
+        {
+            const auto offset = (int) (((juce::int64) blockIndex * blockSize) % numNoiseOffsets);
+
+            buffer.clear();
+
+            for (int ch = 0; ch < numInputChannels; ++ch)
+                buffer.copyFrom (ch, 0, noise, ch, offset, blockSize);
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+
+            return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+        };
+
+        // The warm-up lets the smoothers land on their targets, fills the
+        // tank, and brings the code and the delay lines into the caches.
+        const auto numWarmUpBlocks = juce::jmax (4, (int) (0.1 * sampleRate / blockSize));
+        const auto numBlocks = juce::jmax (16, (int) std::ceil (seconds * sampleRate / blockSize));
+
+        for (int i = 0; i < numWarmUpBlocks; ++i)
+            processNextBlock (i);
+
+        Measurement measurement;
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            const auto blockSeconds = processNextBlock (numWarmUpBlocks + i);
+
+            measurement.totalSeconds += blockSeconds;
+            measurement.worstBlockSeconds = juce::jmax (measurement.worstBlockSeconds, blockSeconds);
+        }
+
+        measurement.numBlocks = numBlocks;
+        measurement.numSamples = (juce::int64) numBlocks * blockSize;
+
+        processor.releaseResources();
+        return measurement;
+    }
+
+    /** Writes a stand-in impulse response: stereo white noise falling by
+        60 dB over its length, with different noise in each channel. It goes
+        to a file because that's what the processor loads.
+    */
+    juce::Result writeSyntheticImpulse (const juce::File& file, double seconds)
+    {
+        const double sampleRate = 48000.0;
+        const auto length = (int) (seconds * sampleRate);
+        const auto decayPerSample = (float) std::pow (0.001, 1.0 / length);
+
+        juce::AudioBuffer<float> impulse (2, length);
+        juce::Random random (2);
+
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+        {
+            auto gain = 0.5f;
+
+            for (int n = 0; n < length; ++n, gain *= decayPerSample)
+                impulse.setSample (ch, n, gain * (2.0f * random.nextFloat() - 1.0f));
+        }
+
+        juce::WavAudioFormat wav;
+        auto stream = file.createOutputStream();
+
+        if (stream == nullptr || stream->failedToOpen())
+            return juce::Result::fail ("Can't write the impulse response to " + file.getFullPathName());
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate,
+                                                                              (unsigned int) impulse.getNumChannels(),
+                                                                              32, {}, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail ("Can't write the impulse response to " + file.getFullPathName());
+
+        // The writer owns the stream now.
+        stream.release();
+
+        return writer->writeFromAudioSampleBuffer (impulse, 0, length)
+                 ? juce::Result::ok()
+                 : juce::Result::fail ("Can't write the impulse response to " + file.getFullPathName());
+    }
+
+    /** Times the tremolo's gain kernel, WavetableLFO::fillGainCurve(), on
+        its own at each block size. Every waveform is read from its table by
+        the same kernel, so one table stands in for all of them.
+
+        For comparison, it also times the loop the tables replaced, which
+        called the shape function once per sample for every channel.
+    */
+    juce::Array<juce::var> measureTremoloKernel (const Sweep& sweep)
+    {
+        const double sampleRate = 48000.0;
+        const auto frequency = 2.0f / (float) sampleRate;
+        const auto phaseOffset = 0.25f;
+
+        const WavetableLFO::ShapeFunction shape = [] (float phase, int)
+        {
+            return 0.5f + 0.5f * std::sin (juce::MathConstants<float>::twoPi * phase);
+        };
+
+        WavetableLFO tables;
+        tables.prepare (sampleRate, 10.0f, 1, shape);
+
+        juce::Array<juce::var> results;
+
+        // Keeps the kernel's output live, so the calls can't be optimised out.
+        volatile float sink = 0.0f;
+
+        for (auto blockSize : sweep.blockSizes)
+        {
+            std::vector<float> phases ((size_t) blockSize), depth ((size_t) blockSize, 0.5f), gain ((size_t) blockSize);
+            auto phase = 0.0f;
+
+            auto tableKernel = [&]
+            {
+                tables.fillGainCurve (0, phases.data(), phaseOffset, depth.data(), gain.data(), blockSize);
+            };
+
+            auto perSampleKernel = [&]
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    auto shifted = phases[(size_t) i] + phaseOffset;
+                    shifted -= shifted >= 1.0f ? 1.0f : 0.0f;
+
+                    const auto d = depth[(size_t) i];
+                    gain[(size_t) i] = 1.0f - d + d * shape (shifted, 0);
+                }
+            };
+
+            auto processNextBlock = [&] (auto& kernel)
+            {
+                for (auto& p : phases)
+                {
+                    p = phase;
+                    phase += frequency;
+                    phase -= phase >= 1.0f ? 1.0f : 0.0f;
+                }
+
+                const auto start = juce::Time::getHighResolutionTicks();
+                kernel();
+                const auto ticks = juce::Time::getHighResolutionTicks() - start;
+
+                sink = sink + gain[0];
+                return juce::Time::highResolutionTicksToSeconds (ticks);
+            };
+
+            const auto numBlocks = juce::jmax (16, (int) std::ceil (sweep.seconds * sampleRate / blockSize));
+
+            auto measure = [&] (auto& kernel)
+            {
+                for (int i = 0; i < 4; ++i)
+                    processNextBlock (kernel);
+
+                auto totalSeconds = 0.0;
+
+                for (int i = 0; i < numBlocks; ++i)
+                    totalSeconds += processNextBlock (kernel);
+
+                return 1.0e9 * totalSeconds / ((double) numBlocks * blockSize);
+            };
+
+            const auto nsPerSample = measure (tableKernel);
+            const auto perSampleNsPerSample = measure (perSampleKernel);
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty ("blockSize", blockSize);
+            result->setProperty ("numBlocks", numBlocks);
+            result->setProperty ("nsPerSample", nsPerSample);
+            result->setProperty ("perSampleNsPerSample", perSampleNsPerSample);
+            result->setProperty ("speedup", perSampleNsPerSample / nsPerSample);
+            results.add (juce::var (result));
+
+            std::cerr << "tremolo kernel, " << blockSize << " samples: "
+                      << juce::String (nsPerSample, 2) << " ns/sample, per-sample shape "
+                      << juce::String (perSampleNsPerSample, 2) << " ns/sample ("
+                      << juce::String (perSampleNsPerSample / nsPerSample, 1) << "x)" << std::endl;
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    juce::var describeMachine()
+    {
+        auto* machine = new juce::DynamicObject();
+
+        machine->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty ("cpuVendor", juce::SystemStats::getCpuVendor());
+        machine->setProperty ("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+        machine->setProperty ("numCpus", juce::SystemStats::getNumCpus());
+
+        return machine;
+    }
+
+    juce::Result runSweep (const Sweep& sweep, juce::Array<juce::var>& results)
+    {
+        // White noise peaking at -12 dB, so no engine is ever idle.
+        juce::AudioBuffer<float> noise (12, noiseLength);
+        juce::Random random (1);
+
+        for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+            for (int n = 0; n < noise.getNumSamples(); ++n)
+                noise.setSample (ch, n, 0.25f * (2.0f * random.nextFloat() - 1.0f));
+
+        auto numWaveforms = 0;
+
+        {
+            SimpleReverbAudioProcessor processor;
+            numWaveforms = processor.waveformItemsUI.size();
+
+            auto* algorithm = dynamic_cast<juce::AudioParameterChoice*> (processor.apvts.getParameter ("algorithm"));
+
+            for (auto& name : sweep.algorithms)
+                if (algorithm == nullptr || ! algorithm->choices.contains (name))
+                    return juce::Result::fail ("There's no algorithm called " + name);
+        }
+
+        // Without an impulse response the convolution engine would only
+        // pass the dry signal through, so it gets a synthetic one.
+        juce::TemporaryFile syntheticImpulse (".wav");
+        auto impulseResponse = sweep.impulseResponse;
+
+        if (sweep.algorithms.contains ("Convolution") && impulseResponse == juce::File())
+        {
+            auto result = writeSyntheticImpulse (syntheticImpulse.getFile(), 2.0);
+
+            if (result.failed())
+                return result;
+
+            impulseResponse = syntheticImpulse.getFile();
+        }
+
+        const auto numCases = sweep.layouts.size() * sweep.algorithms.size() * 2 * numWaveforms
+                                * sweep.sampleRates.size() * sweep.blockSizes.size();
+        auto caseIndex = 0;
+
+        for (auto& layout : sweep.layouts)
+        {
+            // A fresh processor per layout, as the buses can only change
+            // while it's not prepared.
+            SimpleReverbAudioProcessor processor;
+
+            juce::AudioProcessor::BusesLayout buses;
+            buses.inputBuses .add (getChannelSet (layout));
+            buses.outputBuses.add (getChannelSet (layout));
+
+            if (! processor.setBusesLayout (buses))
+                return juce::Result::fail ("The processor doesn't support " + layout);
+
+            if (impulseResponse != juce::File() && ! processor.loadImpulseResponse (impulseResponse))
+                return juce::Result::fail ("Can't read the impulse response " + impulseResponse.getFullPathName());
+
+            const auto numChannels = processor.getTotalNumOutputChannels();
+
+            for (auto& algorithm : sweep.algorithms)
+            {
+                setParameter (processor, "algorithm", algorithm);
+
+                for (auto freeze : { false, true })
+                {
+                    setParameter (processor, "freeze", freeze ? "1" : "0");
+
+                    for (int waveform = 0; waveform < numWaveforms; ++waveform)
+                    {
+                        const auto& waveformName = processor.waveformItemsUI[waveform];
+                        setParameter (processor, "lfowaveform", waveformName);
+
+                        for (auto sampleRate : sweep.sampleRates)
+                        {
+                            for (auto blockSize : sweep.blockSizes)
+                            {
+                                const auto m = measure (processor, sampleRate, blockSize, sweep.seconds, noise);
+
+                                const auto nsPerSample = 1.0e9 * m.totalSeconds / (double) m.numSamples;
+                                const auto deadlineSeconds = blockSize / sampleRate;
+                                const auto audioSeconds = (double) m.numSamples / sampleRate;
+
+                                auto* result = new juce::DynamicObject();
+                                result->setProperty ("algorithm", algorithm);
+                                result->setProperty ("layout", layout);
+                                result->setProperty ("numChannels", numChannels);
+                                result->setProperty ("sampleRate", sampleRate);
+                                result->setProperty ("blockSize", blockSize);
+                                result->setProperty ("freeze", freeze);
+                                result->setProperty ("waveform", waveformName);
+                                result->setProperty ("numBlocks", m.numBlocks);
+                                result->setProperty ("nsPerSample", nsPerSample);
+                                result->setProperty ("nsPerChannelSample", nsPerSample / numChannels);
+                                result->setProperty ("meanBlockMicroseconds", 1.0e6 * m.totalSeconds / m.numBlocks);
+                                result->setProperty ("worstBlockMicroseconds", 1.0e6 * m.worstBlockSeconds);
+
+                                // The share of the block's real-time deadline the slowest
+                                // block used, which is what limits the instance count.
+                                result->setProperty ("worstBlockLoad", m.worstBlockSeconds / deadlineSeconds);
+                                result->setProperty ("realtimeFactor", m.totalSeconds > 0.0 ? audioSeconds / m.totalSeconds : 0.0);
+
+                                results.add (juce::var (result));
+
+                                std::cerr << "[" << ++caseIndex << "/" << numCases << "] "
+                                          << algorithm << " " << layout << ", "
+                                          << juce::String (sampleRate, 0) << " Hz, " << blockSize << " samples, freeze "
+                                          << (freeze ? "on" : "off") << ", " << waveformName << ": "
+                                          << juce::String (nsPerSample, 1) << " ns/sample, worst block "
+                                          << juce::String (1.0e6 * m.worstBlockSeconds, 1) << " us" << std::endl;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        return juce::Result::ok();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor's parameter tree needs a message manager, even though
+    // nothing here runs a message loop.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    Sweep sweep;
+    auto result = parseArguments (args, sweep);
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n\n";
+        printUsage();
+        return 1;
+    }
+
+   #if JUCE_DEBUG
+    const bool isDebugBuild = true;
+    std::cerr << "This is a debug build, so the timings say little about a release one" << std::endl;
+   #else
+    const bool isDebugBuild = false;
+   #endif
+
+    juce::Array<juce::var> results;
+    result = runSweep (sweep, results);
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl;
+        return 1;
+    }
+
+    const auto tremoloKernel = measureTremoloKernel (sweep);
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty ("machine", describeMachine());
+    report->setProperty ("debugBuild", isDebugBuild);
+    report->setProperty ("secondsPerCase", sweep.seconds);
+    if (sweep.algorithms.contains ("Convolution"))
+        report->setProperty ("impulseResponse", sweep.impulseResponse != juce::File() ? sweep.impulseResponse.getFileName()
+                                                                                     : juce::String ("synthetic"));
+
+    report->setProperty ("results", results);
+    report->setProperty ("tremoloKernel", tremoloKernel);
+
+    const auto json = juce::JSON::toString (juce::var (report));
+
+    if (sweep.output == juce::File())
+    {
+        std::cout << json << std::endl;
+    }
+    else if (! sweep.output.replaceWithText (json))
+    {
+        std::cerr << "Can't write to " << sweep.output.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
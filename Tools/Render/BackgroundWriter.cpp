@@ -0,0 +1,104 @@
+#include "BackgroundWriter.h"
+
+//==============================================================================
+BackgroundWriter::BackgroundWriter (std::unique_ptr<juce::AudioFormatWriter> w, int numChannels, int capacity)
+    : juce::Thread ("Render writer"),
+      writer (std::move (w)),
+      ring (numChannels, capacity),
+      fifo (capacity)
+{
+    jassert (writer != nullptr);
+    startThread();
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+    finish();
+}
+
+int BackgroundWriter::getDefaultCapacity (double sampleRate, int blockSize)
+{
+    return juce::jmax ((int) sampleRate, blockSize * 4);
+}
+
+bool BackgroundWriter::write (const juce::AudioBuffer<float>& source, int numSamples)
+{
+    jassert (source.getNumChannels() >= ring.getNumChannels());
+    jassert (! finishing);
+
+    for (int done = 0; done < numSamples;)
+    {
+        if (failed)
+            return false;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (numSamples - done, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            spaceFreed.wait (100);
+            continue;
+        }
+
+        for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+        {
+            ring.copyFrom (ch, start1, source, ch, done, size1);
+
+            if (size2 > 0)
+                ring.copyFrom (ch, start2, source, ch, done + size1, size2);
+        }
+
+        fifo.finishedWrite (size1 + size2);
+        dataReady.signal();
+
+        done += size1 + size2;
+    }
+
+    return ! failed;
+}
+
+bool BackgroundWriter::finish()
+{
+    if (writer != nullptr)
+    {
+        finishing = true;
+        dataReady.signal();
+        waitForThreadToExit (-1);
+
+        // Deleting the writer updates the header and closes the file.
+        writer.reset();
+    }
+
+    return ! failed;
+}
+
+void BackgroundWriter::run()
+{
+    for (;;)
+    {
+        // Read before checking the numbers, so nothing queued just before
+        // finish() is left behind.
+        const bool lastPass = finishing;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            if (lastPass)
+                return;
+
+            dataReady.wait (100);
+            continue;
+        }
+
+        if (! failed && ! (writer->writeFromAudioSampleBuffer (ring, start1, size1)
+                            && (size2 == 0 || writer->writeFromAudioSampleBuffer (ring, start2, size2))))
+            failed = true;
+
+        // After a failure the ring is still drained, so write() never waits
+        // forever.
+        fifo.finishedRead (size1 + size2);
+        spaceFreed.signal();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Writes to an AudioFormatWriter on its own thread, so the render doesn't
+    wait on the disk.
+
+    Blocks are copied into a fixed ring guarded by an AbstractFifo. The
+    render thread only waits when the ring is full, which bounds the memory
+    used however long the file is.
+*/
+class BackgroundWriter  : private juce::Thread
+{
+public:
+    /** Takes ownership of writer. The ring holds capacity samples per channel. */
+    BackgroundWriter (std::unique_ptr<juce::AudioFormatWriter> writer, int numChannels, int capacity);
+
+    /** Finishes writing, if finish() hasn't been called. */
+    ~BackgroundWriter() override;
+
+    /** Queues the first numSamples of the first numChannels of source,
+        waiting for room if the ring is full. Returns false once a write has
+        failed.
+    */
+    bool write (const juce::AudioBuffer<float>& source, int numSamples);
+
+    /** Waits for everything queued to reach the file, then closes it.
+        Returns false if any write failed.
+    */
+    bool finish();
+
+    /** A ring of about a second, and never less than a few blocks. */
+    static int getDefaultCapacity (double sampleRate, int blockSize);
+
+private:
+    void run() override;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::AudioBuffer<float> ring;
+    juce::AbstractFifo fifo;
+
+    juce::WaitableEvent dataReady, spaceFreed;
+    std::atomic<bool> finishing { false }, failed { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BackgroundWriter)
+};
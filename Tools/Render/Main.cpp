@@ -0,0 +1,537 @@
+/*
+  ==============================================================================
+
+    SimpleReverbRender: renders audio files, or raw streams, through the
+    plugin's processor from the command line, with no GUI or host.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RenderJobPool.h"
+#include "RenderManifest.h"
+#include "SegmentedRenderer.h"
+#include "StreamRenderer.h"
+
+#include <iostream>
+#include <set>
+
+#if JUCE_WINDOWS
+ #include <fcntl.h>
+ #include <io.h>
+#endif
+
+//==============================================================================
+namespace
+{
+    void printUsage()
+    {
+        // Usage goes to stderr, as it only follows a mistake, and in stream
+        // mode stdout carries the audio.
+        std::cerr << "Usage: SimpleReverbRender [options] <input> <output>\n"
+                     "       SimpleReverbRender [options] --output-dir <dir> <inputs or folders...>\n"
+                     "       SimpleReverbRender [options] --stream < input.raw > output.raw\n"
+                     "\n"
+                     "Options:\n"
+                     "  --param <id>=<value>   Sets a parameter within its own range. Can be repeated,\n"
+                     "                         e.g. --param size=0.8 --param algorithm=FDN\n"
+                     "  --preset <file>        Loads a state saved by the plugin first\n"
+                     "  --ir <file>            Impulse response for the convolution algorithm\n"
+                     "  --automation <file>    Timed reverb parameter changes, one per line:\n"
+                     "                         <seconds> <id> <value>, e.g. 2.5 freeze on\n"
+                     "  --block-size <n>       Samples per block (default 512)\n"
+                     "  --tail <seconds>       Silence rendered after the input\n"
+                     "                         (default: the reverb's tail, up to 30 s)\n"
+                     "  --mono-to-stereo       Renders mono input to a stereo output\n"
+                     "  --list-params          Lists the parameters and their defaults\n"
+                     "\n"
+                     "Long files:\n"
+                     "  --segments <n>         Splits a single file into n pieces rendered at once\n"
+                     "  --pre-roll <seconds>   Input each piece runs through first to warm up the reverb\n"
+                     "                         (default: the reverb's tail length)\n"
+                     "  --seam-tolerance <dB>  Largest difference allowed where pieces meet (default -90)\n"
+                     "\n"
+                     "Batch options:\n"
+                     "  --output-dir <dir>     Renders every input to a file of the same name in dir\n"
+                     "  --jobs <n>             Files rendered at once (default: one per core)\n"
+                     "  --manifest <file>      Where finished files are logged\n"
+                     "                         (default: SimpleReverbRender.manifest in the output dir)\n"
+                     "  --no-resume            Renders everything again, rather than skipping the\n"
+                     "                         files the manifest lists as done\n"
+                     "\n"
+                     "Stream options:\n"
+                     "  --stream               Filters raw interleaved PCM from stdin to stdout\n"
+                     "  --rate <hz>            The stream's sample rate (default 44100)\n"
+                     "  --channels <n>         The stream's channel count (default 2)\n"
+                     "  --format <f32|s16|s24|s32>\n"
+                     "                         Little-endian float or integer samples (default f32)\n"
+                     "\n"
+                     "The output format is picked from the output's extension (.wav, .aiff).\n";
+    }
+
+    struct BatchOptions
+    {
+        juce::File outputDirectory, manifest;
+        int numJobs = juce::SystemStats::getNumCpus();
+        bool resume = true;
+    };
+
+    struct StreamOptions
+    {
+        StreamFormat format;
+        bool enabled = false;
+    };
+
+    juce::File getFile (const juce::String& path)
+    {
+        return juce::File::getCurrentWorkingDirectory().getChildFile (path.unquoted());
+    }
+
+    /** Fills in the settings and the files from the arguments. Returns an
+        error if they don't make sense.
+    */
+    juce::Result parseArguments (const juce::StringArray& args, RenderSettings& settings, BatchOptions& batch,
+                                 StreamOptions& stream, juce::StringArray& files, bool& listParameters)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            const auto& arg = args[i];
+
+            auto nextValue = [&] (juce::String& value)
+            {
+                if (i + 1 >= args.size())
+                    return false;
+
+                value = args[++i];
+                return true;
+            };
+
+            juce::String value;
+
+            if (arg == "--list-params")
+            {
+                listParameters = true;
+            }
+            else if (arg == "--mono-to-stereo")
+            {
+                settings.monoToStereo = true;
+            }
+            else if (arg == "--no-resume")
+            {
+                batch.resume = false;
+            }
+            else if (arg == "--stream")
+            {
+                stream.enabled = true;
+            }
+            else if (arg == "--rate")
+            {
+                if (! nextValue (value) || value.getDoubleValue() <= 0.0)
+                    return juce::Result::fail ("--rate needs a sample rate in Hz");
+
+                stream.format.sampleRate = value.getDoubleValue();
+            }
+            else if (arg == "--channels")
+            {
+                if (! nextValue (value) || value.getIntValue() <= 0)
+                    return juce::Result::fail ("--channels needs a number of channels");
+
+                stream.format.numChannels = value.getIntValue();
+            }
+            else if (arg == "--format")
+            {
+                if (! nextValue (value) || ! StreamFormat::parseEncoding (value, stream.format.encoding))
+                    return juce::Result::fail ("--format needs one of f32, s16, s24 or s32");
+            }
+            else if (arg == "--output-dir" || arg == "--manifest")
+            {
+                if (! nextValue (value))
+                    return juce::Result::fail (arg + " needs a path");
+
+                (arg == "--output-dir" ? batch.outputDirectory : batch.manifest) = getFile (value);
+            }
+            else if (arg == "--jobs")
+            {
+                if (! nextValue (value) || value.getIntValue() <= 0)
+                    return juce::Result::fail ("--jobs needs a number of files");
+
+                batch.numJobs = value.getIntValue();
+            }
+            else if (arg == "--param")
+            {
+                if (! nextValue (value) || ! value.containsChar ('='))
+                    return juce::Result::fail ("--param needs <id>=<value>");
+
+                settings.parameterValues.set (value.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                              value.fromFirstOccurrenceOf ("=", false, false).trim());
+            }
+            else if (arg == "--preset" || arg == "--ir" || arg == "--automation")
+            {
+                if (! nextValue (value))
+                    return juce::Result::fail (arg + " needs a file");
+
+                (arg == "--preset" ? settings.preset
+                                   : arg == "--ir" ? settings.impulseResponse
+                                                   : settings.automation) = getFile (value);
+            }
+            else if (arg == "--block-size")
+            {
+                if (! nextValue (value) || value.getIntValue() <= 0)
+                    return juce::Result::fail ("--block-size needs a number of samples");
+
+                settings.blockSize = value.getIntValue();
+            }
+            else if (arg == "--segments")
+            {
+                if (! nextValue (value) || value.getIntValue() <= 0)
+                    return juce::Result::fail ("--segments needs a number of pieces");
+
+                settings.numSegments = value.getIntValue();
+            }
+            else if (arg == "--pre-roll")
+            {
+                if (! nextValue (value))
+                    return juce::Result::fail ("--pre-roll needs a number of seconds");
+
+                settings.preRollSeconds = juce::jmax (0.0, value.getDoubleValue());
+            }
+            else if (arg == "--seam-tolerance")
+            {
+                if (! nextValue (value))
+                    return juce::Result::fail ("--seam-tolerance needs a level in dB");
+
+                settings.seamToleranceDecibels = value.getDoubleValue();
+            }
+            else if (arg == "--tail")
+            {
+                if (! nextValue (value))
+                    return juce::Result::fail ("--tail needs a number of seconds");
+
+                settings.tailSeconds = juce::jmax (0.0, value.getDoubleValue());
+            }
+            else if (arg.startsWith ("--"))
+            {
+                return juce::Result::fail ("Unknown option " + arg);
+            }
+            else
+            {
+                files.add (arg);
+            }
+        }
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    /** Turns the inputs, files or folders of audio files, into jobs that write
+        to the output directory. Fails if two inputs would share an output, or
+        if an output would replace its own input.
+    */
+    juce::Result collectJobs (const juce::StringArray& inputs, const juce::File& outputDirectory,
+                              std::vector<RenderJob>& jobs)
+    {
+        juce::Array<juce::File> inputFiles;
+
+        for (auto& path : inputs)
+        {
+            const auto file = getFile (path);
+
+            // Each render is moved over a file of the same name in the
+            // output folder, which here would be its own source.
+            if (file.isDirectory() && file == outputDirectory)
+                return juce::Result::fail ("The output folder can't also be an input folder: " + file.getFullPathName());
+
+            if (file.isDirectory())
+                inputFiles.addArray (file.findChildFiles (juce::File::findFiles, false, "*.wav;*.aif;*.aiff"));
+            else if (file.existsAsFile())
+                inputFiles.add (file);
+            else
+                return juce::Result::fail ("Can't find " + file.getFullPathName());
+        }
+
+        std::set<juce::String> outputs;
+
+        for (auto& input : inputFiles)
+        {
+            const auto output = outputDirectory.getChildFile (input.getFileName());
+
+            if (output == input)
+                return juce::Result::fail ("Rendering " + input.getFullPathName() + " would replace it");
+
+            if (! outputs.insert (output.getFullPathName()).second)
+                return juce::Result::fail ("More than one input would be written to " + output.getFullPathName());
+
+            jobs.push_back ({ input, output, input.getSize() });
+        }
+
+        return juce::Result::ok();
+    }
+
+    int renderSegmented (const RenderSettings& settings, const juce::StringArray& files)
+    {
+        SegmentedRenderer renderer (settings);
+        auto result = renderer.initialise();
+
+        const auto input  = getFile (files[0]);
+        const auto output = getFile (files[1]);
+
+        RenderStats stats;
+
+        if (result.wasOk())
+            result = renderer.renderFile (input, output, stats);
+
+        if (renderer.getNumSegmentsUsed() > 0)
+            std::cout << input.getFileName() << " -> " << output.getFileName() << ": "
+                      << renderer.getNumSegmentsUsed() << " segments with "
+                      << juce::String ((double) renderer.getPreRollSamples() / juce::jmax (1.0, stats.sampleRate), 2) << " s pre-roll, "
+                      << "worst seam " << juce::String (renderer.getWorstSeamErrorDecibels(), 1) << " dB, "
+                      << juce::String (stats.getAudioSeconds(), 2) << " s of audio in "
+                      << juce::String (stats.wallSeconds, 2) << " s ("
+                      << juce::String (stats.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int renderSingle (const RenderSettings& settings, const juce::StringArray& files)
+    {
+        if (settings.numSegments > 1)
+            return renderSegmented (settings, files);
+
+        OfflineRenderer renderer (settings);
+        auto result = renderer.initialise();
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        const auto input  = getFile (files[0]);
+        const auto output = getFile (files[1]);
+
+        RenderStats stats;
+        result = renderer.renderFile (input, output, stats);
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        std::cout << input.getFileName() << " -> " << output.getFileName() << ": "
+                  << juce::String (stats.getAudioSeconds(), 2) << " s of audio in "
+                  << juce::String (stats.wallSeconds, 2) << " s ("
+                  << juce::String (stats.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        return 0;
+    }
+
+    int renderStream (const RenderSettings& settings, const StreamFormat& format)
+    {
+       #if JUCE_WINDOWS
+        _setmode (_fileno (stdin),  _O_BINARY);
+        _setmode (_fileno (stdout), _O_BINARY);
+       #endif
+
+        StreamRenderer renderer (settings, format);
+        auto result = renderer.initialise();
+
+        RenderStats stats;
+
+        if (result.wasOk())
+            result = renderer.run (stdin, stdout, stats);
+
+        // stdout carries the audio, so everything else goes to stderr.
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        std::cerr << "stream: " << format.numChannels << " -> " << renderer.getNumOutputChannels() << " channels, "
+                  << juce::String (stats.getAudioSeconds(), 2) << " s of audio in "
+                  << juce::String (stats.wallSeconds, 2) << " s ("
+                  << juce::String (stats.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        return 0;
+    }
+
+    int renderBatch (const RenderSettings& settings, const BatchOptions& batch, const juce::StringArray& inputs)
+    {
+        std::vector<RenderJob> allJobs, jobs;
+        auto result = collectJobs (inputs, batch.outputDirectory, allJobs);
+
+        if (result.wasOk())
+            result = batch.outputDirectory.createDirectory();
+
+        RenderManifest manifest;
+
+        if (result.wasOk())
+            result = manifest.open (batch.manifest != juce::File() ? batch.manifest
+                                                                   : batch.outputDirectory.getChildFile ("SimpleReverbRender.manifest"),
+                                    batch.resume);
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        for (auto& job : allJobs)
+            if (! manifest.isDone (job.input, job.output))
+                jobs.push_back (job);
+
+        const auto numSkipped = allJobs.size() - jobs.size();
+
+        RenderJobPool pool (settings, juce::jmin (batch.numJobs, juce::jmax (1, (int) jobs.size())));
+        result = pool.initialise();
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        if (numSkipped > 0)
+            std::cout << "Skipping " << (int) numSkipped << " files the manifest lists as done" << std::endl;
+
+        juce::CriticalSection outputLock;
+        size_t numFinished = 0, numFailed = 0;
+        double audioSeconds = 0.0;
+
+        const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+        pool.run (jobs, [&] (const RenderJob& job, const juce::Result& jobResult, const RenderStats& stats)
+        {
+            if (jobResult.wasOk())
+                manifest.markDone (job.input, job.output, stats);
+            else
+                manifest.markFailed (job.input, jobResult.getErrorMessage());
+
+            const juce::ScopedLock sl (outputLock);
+            const auto progress = "[" + juce::String ((int) ++numFinished) + "/" + juce::String ((int) jobs.size()) + "] ";
+
+            if (jobResult.wasOk())
+            {
+                audioSeconds += stats.getAudioSeconds();
+                std::cout << progress << job.input.getFileName() << ": "
+                          << juce::String (stats.getRealtimeFactor(), 1) << "x realtime" << std::endl;
+            }
+            else
+            {
+                ++numFailed;
+                std::cerr << progress << job.input.getFileName() << " failed: " << jobResult.getErrorMessage() << std::endl;
+            }
+        });
+
+        const auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+        std::cout << "Rendered " << (int) (numFinished - numFailed) << " files";
+
+        if (numFailed > 0)
+            std::cout << " (" << (int) numFailed << " failed)";
+
+        std::cout << " on " << pool.getNumWorkers() << " threads: "
+                  << juce::String (audioSeconds, 2) << " s of audio in "
+                  << juce::String (wallSeconds, 2) << " s ("
+                  << juce::String (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0, 1) << "x realtime)" << std::endl;
+
+        return numFailed > 0 ? 1 : 0;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    // The processor's parameter tree needs a message manager, even though
+    // nothing here runs a message loop.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    RenderSettings settings;
+    BatchOptions batch;
+    StreamOptions stream;
+    juce::StringArray files;
+    bool listParameters = false;
+
+    auto result = parseArguments (args, settings, batch, stream, files, listParameters);
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n\n";
+        printUsage();
+        return 1;
+    }
+
+    if (listParameters)
+    {
+        OfflineRenderer renderer (settings);
+        result = renderer.initialise();
+
+        if (result.failed())
+        {
+            std::cerr << result.getErrorMessage() << std::endl;
+            return 1;
+        }
+
+        for (auto& line : OfflineRenderer::describeParameters (renderer.getProcessor()))
+            std::cout << line << "\n";
+
+        return 0;
+    }
+
+    if (stream.enabled)
+    {
+        if (! files.isEmpty() || batch.outputDirectory != juce::File() || settings.numSegments > 1)
+        {
+            std::cerr << "--stream reads stdin and writes stdout, so it takes no files\n\n";
+            printUsage();
+            return 1;
+        }
+
+        return renderStream (settings, stream.format);
+    }
+
+    if (batch.outputDirectory != juce::File())
+    {
+        if (files.isEmpty())
+        {
+            printUsage();
+            return 1;
+        }
+
+        if (settings.numSegments > 1)
+        {
+            std::cerr << "--segments splits a single file, so it can't be used with --output-dir\n\n";
+            printUsage();
+            return 1;
+        }
+
+        return renderBatch (settings, batch, files);
+    }
+
+    if (files.size() != 2)
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (getFile (files[0]) == getFile (files[1]))
+    {
+        std::cerr << "The output can't be the input, as it's replaced before the input is read\n";
+        return 1;
+    }
+
+    return renderSingle (settings, files);
+}
@@ -0,0 +1,46 @@
+#include "MappedAudioInput.h"
+
+//==============================================================================
+juce::Result MappedAudioInput::open (juce::AudioFormatManager& formatManager, const juce::File& file)
+{
+    mapped = nullptr;
+    reader.reset();
+
+    if (auto* format = formatManager.findFormatForFileExtension (file.getFileExtension()))
+    {
+        if (auto* mappedReader = format->createMemoryMappedReader (file))
+        {
+            mapped = mappedReader;
+            reader.reset (mappedReader);
+
+            const auto bytesPerFrame = juce::jmax (1, (int) (mappedReader->numChannels * mappedReader->bitsPerSample / 8));
+            windowLength = (juce::int64) windowBytes / bytesPerFrame;
+        }
+    }
+
+    if (reader == nullptr)
+        reader.reset (formatManager.createReaderFor (file));
+
+    if (reader == nullptr)
+        return juce::Result::fail ("Can't read " + file.getFullPathName());
+
+    return juce::Result::ok();
+}
+
+bool MappedAudioInput::read (juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples)
+{
+    jassert (reader != nullptr);
+
+    if (mapped != nullptr)
+    {
+        const juce::Range<juce::int64> needed (start, juce::jmin (reader->lengthInSamples, start + numSamples));
+
+        // Mapping the next window drops the old one, and the pages behind
+        // it, so resident memory stays at one window.
+        if (! needed.isEmpty() && ! mapped->getMappedSection().contains (needed))
+            if (! mapped->mapSectionOfFile ({ start, juce::jmin (reader->lengthInSamples, start + juce::jmax (windowLength, (juce::int64) numSamples)) }))
+                return false;
+    }
+
+    return reader->read (&destination, 0, numSamples, start, true, true);
+}
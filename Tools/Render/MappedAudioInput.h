@@ -0,0 +1,38 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Reads an input file through a memory-mapped window that slides along as
+    the render moves through it, so only the window is ever mapped however
+    large the file is.
+
+    WAV and AIFF are mapped. Other formats fall back to the format's own
+    streaming reader, which never holds the whole file either.
+*/
+class MappedAudioInput
+{
+public:
+    MappedAudioInput() = default;
+
+    juce::Result open (juce::AudioFormatManager& formatManager, const juce::File& file);
+
+    /** The reader, for the file's rate, channels, length and metadata. */
+    const juce::AudioFormatReader& getReader() const noexcept   { return *reader; }
+
+    /** Reads numSamples from start into the front of destination. Samples
+        past the end of the file come back as silence.
+    */
+    bool read (juce::AudioBuffer<float>& destination, juce::int64 start, int numSamples);
+
+    bool isMapped() const noexcept { return mapped != nullptr; }
+
+    /** The largest stretch of the file mapped at once. */
+    static constexpr size_t windowBytes = 64 * 1024 * 1024;
+
+private:
+    juce::MemoryMappedAudioFormatReader* mapped = nullptr;   // reader, if it's mapped
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::int64 windowLength = 0;
+};
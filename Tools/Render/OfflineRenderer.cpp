@@ -0,0 +1,349 @@
+#include "OfflineRenderer.h"
+
+//==============================================================================
+namespace
+{
+    juce::AudioProcessorParameterWithID* findParameter (juce::AudioProcessor& processor, const juce::String& parameterID)
+    {
+        for (auto* parameter : processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+                if (withID->paramID.equalsIgnoreCase (parameterID))
+                    return withID;
+
+        return nullptr;
+    }
+}
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer (const RenderSettings& s)
+    : settings (s),
+      processor (std::make_unique<SimpleReverbAudioProcessor>())
+{
+    formatManager.registerBasicFormats();
+}
+
+juce::Result OfflineRenderer::initialise()
+{
+    if (settings.blockSize <= 0)
+        return juce::Result::fail ("The block size has to be at least one sample");
+
+    processor->setNonRealtime (true);
+
+    auto result = applySettings();
+
+    if (result.wasOk())
+        settle();
+
+    return result;
+}
+
+juce::Result OfflineRenderer::applySettings()
+{
+    // The preset goes first, so that single parameters can override it.
+    if (settings.preset != juce::File())
+    {
+        if (! settings.preset.existsAsFile())
+            return juce::Result::fail ("Can't find the preset " + settings.preset.getFullPathName());
+
+        juce::MemoryBlock state;
+
+        if (auto xml = juce::parseXML (settings.preset))
+            juce::AudioProcessor::copyXmlToBinary (*xml, state);
+        else
+            settings.preset.loadFileAsData (state);
+
+        processor->setStateInformation (state.getData(), (int) state.getSize());
+        processor->waitForImpulseResponse();
+    }
+
+    if (settings.impulseResponse != juce::File()
+         && ! processor->loadImpulseResponse (settings.impulseResponse))
+        return juce::Result::fail ("Can't read the impulse response " + settings.impulseResponse.getFullPathName());
+
+    for (auto& parameterID : settings.parameterValues.getAllKeys())
+    {
+        auto* parameter = findParameter (*processor, parameterID);
+
+        if (parameter == nullptr)
+            return juce::Result::fail ("There's no parameter called " + parameterID);
+
+        parameter->setValueNotifyingHost (parameter->getValueForText (settings.parameterValues[parameterID]));
+    }
+
+    return loadAutomation();
+}
+
+juce::Result OfflineRenderer::loadAutomation()
+{
+    automation.clear();
+
+    if (settings.automation == juce::File())
+        return juce::Result::ok();
+
+    if (! settings.automation.existsAsFile())
+        return juce::Result::fail ("Can't find the automation " + settings.automation.getFullPathName());
+
+    juce::StringArray lines;
+    settings.automation.readLines (lines);
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        const auto line = lines[i].trim();
+
+        if (line.isEmpty() || line.startsWithChar ('#'))
+            continue;
+
+        const auto where = settings.automation.getFileName() + " line " + juce::String (i + 1) + ": ";
+        const auto tokens = juce::StringArray::fromTokens (line, true);
+
+        if (tokens.size() != 3 || ! tokens[0].containsOnly ("0123456789.eE+-"))
+            return juce::Result::fail (where + "expected <seconds> <parameter ID> <value>");
+
+        auto* parameter = dynamic_cast<juce::RangedAudioParameter*> (findParameter (*processor, tokens[1].unquoted()));
+        const auto index = parameter != nullptr ? SimpleReverbAudioProcessor::getSchedulableParameterIndex (parameter->paramID) : -1;
+
+        if (index < 0)
+            return juce::Result::fail (where + tokens[1] + " isn't a reverb parameter that can be automated");
+
+        // Stored in the parameter's own range, as the processor reads it.
+        const auto value = parameter->convertFrom0to1 (parameter->getValueForText (tokens[2].unquoted()));
+        automation.push_back ({ juce::jmax (0.0, tokens[0].getDoubleValue()), index, value });
+    }
+
+    // Changes at the same time keep the order they were written in.
+    std::stable_sort (automation.begin(), automation.end(),
+                      [] (const AutomationPoint& a, const AutomationPoint& b) { return a.seconds < b.seconds; });
+
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::settle()
+{
+    // The tremolo's smoothers only pick up new settings inside processBlock().
+    // One short block here means every render starts on the final values,
+    // rather than gliding to them from the defaults.
+    const double sampleRate = 44100.0;
+    const int numSamples = 512;
+
+    processor->setRateAndBufferSizeDetails (sampleRate, numSamples);
+    processor->prepareToPlay (sampleRate, numSamples);
+
+    juce::AudioBuffer<float> silence (juce::jmax (processor->getTotalNumInputChannels(),
+                                                  processor->getTotalNumOutputChannels()), numSamples);
+    silence.clear();
+    processor->processBlock (silence, midi);
+
+    processor->releaseResources();
+}
+
+juce::StringArray OfflineRenderer::describeParameters (SimpleReverbAudioProcessor& processor)
+{
+    juce::StringArray lines;
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (parameter))
+            lines.add (withID->paramID + " (" + withID->getName (64) + "): "
+                         + withID->getCurrentValueAsText() + " " + withID->getLabel());
+
+    return lines;
+}
+
+//==============================================================================
+juce::AudioChannelSet OfflineRenderer::getChannelSet (int numChannels)
+{
+    switch (numChannels)
+    {
+        case 1:  return juce::AudioChannelSet::mono();
+        case 2:  return juce::AudioChannelSet::stereo();
+        case 6:  return juce::AudioChannelSet::create5point1();
+        case 8:  return juce::AudioChannelSet::create7point1();
+        case 12: return juce::AudioChannelSet::create7point1point4();
+        default: return juce::AudioChannelSet::discreteChannels (numChannels);
+    }
+}
+
+juce::Result OfflineRenderer::prepare (int numInputChannels, double sampleRate)
+{
+    const auto numOutputChannels = settings.monoToStereo && numInputChannels == 1 ? 2 : numInputChannels;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses .add (getChannelSet (numInputChannels));
+    layout.outputBuses.add (getChannelSet (numOutputChannels));
+
+    if (! processor->setBusesLayout (layout))
+        return juce::Result::fail ("Can't process " + juce::String (numInputChannels) + " channels in to "
+                                     + juce::String (numOutputChannels) + " out");
+
+    // Every file starts from a clean tail, and from the top of the automation.
+    processor->setRateAndBufferSizeDetails (sampleRate, settings.blockSize);
+    processor->prepareToPlay (sampleRate, settings.blockSize);
+
+    currentSampleRate = sampleRate;
+    nextAutomationPoint = 0;
+
+    buffer.setSize (juce::jmax (numInputChannels, numOutputChannels), settings.blockSize);
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::renderFile (const juce::File& input, const juce::File& output, RenderStats& stats)
+{
+    MappedAudioInput mappedInput;
+    auto result = mappedInput.open (formatManager, input);
+
+    if (result.failed())
+        return result;
+
+    const auto& reader = mappedInput.getReader();
+    result = prepare ((int) reader.numChannels, reader.sampleRate);
+
+    std::unique_ptr<BackgroundWriter> writer;
+
+    if (result.wasOk())
+        result = createBackgroundWriter (output, reader, processor->getTotalNumOutputChannels(), writer);
+
+    if (result.failed())
+        return result;
+
+    const auto end = reader.lengthInSamples + getTailLengthSamples (reader.sampleRate);
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    result = process (mappedInput, 0, end, 0, [&writer] (const juce::AudioBuffer<float>& block, juce::int64)
+    {
+        return writer->write (block, block.getNumSamples());
+    });
+
+    // The render only counts as done once the last block is on disk.
+    if (! writer->finish() && result.wasOk())
+        result = juce::Result::fail ("Can't finish writing " + output.getFullPathName());
+
+    stats.numSamples = end;
+    stats.sampleRate = reader.sampleRate;
+    stats.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    return result;
+}
+
+juce::Result OfflineRenderer::createWriter (const juce::File& output, const juce::AudioFormatReader& reader,
+                                            int numChannels, std::unique_ptr<juce::AudioFormatWriter>& writer)
+{
+    auto* format = formatManager.findFormatForFileExtension (output.getFileExtension());
+
+    if (format == nullptr)
+        return juce::Result::fail ("Don't know how to write " + output.getFileName());
+
+    const auto bitDepth = format->getPossibleBitDepths().contains ((int) reader.bitsPerSample)
+                            ? (int) reader.bitsPerSample : 24;
+
+    output.deleteFile();
+    auto stream = output.createOutputStream();
+
+    if (stream == nullptr || stream->failedToOpen())
+        return juce::Result::fail ("Can't write to " + output.getFullPathName());
+
+    writer.reset (format->createWriterFor (stream.get(), reader.sampleRate, (unsigned int) numChannels,
+                                           bitDepth, reader.metadataValues, 0));
+
+    if (writer == nullptr)
+        return juce::Result::fail ("Can't write " + juce::String (numChannels) + " channels at "
+                                     + juce::String (bitDepth) + " bits to " + output.getFileName());
+
+    // The writer owns the stream now.
+    stream.release();
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::createBackgroundWriter (const juce::File& output, const juce::AudioFormatReader& reader,
+                                                      int numChannels, std::unique_ptr<BackgroundWriter>& writer)
+{
+    std::unique_ptr<juce::AudioFormatWriter> formatWriter;
+    auto result = createWriter (output, reader, numChannels, formatWriter);
+
+    if (result.wasOk())
+        writer = std::make_unique<BackgroundWriter> (std::move (formatWriter), numChannels,
+                                                     BackgroundWriter::getDefaultCapacity (reader.sampleRate, settings.blockSize));
+
+    return result;
+}
+
+juce::Result OfflineRenderer::scheduleAutomation (juce::int64 position, int numSamples)
+{
+    auto getSample = [this] (const AutomationPoint& point) { return (juce::int64) std::llround (point.seconds * currentSampleRate); };
+
+    // Changes the render has already passed, e.g. before a segment's
+    // pre-roll, only need their final values.
+    int passedPoints[SimpleReverbAudioProcessor::numReverbParameters];
+    std::fill (std::begin (passedPoints), std::end (passedPoints), -1);
+
+    for (; nextAutomationPoint < automation.size() && getSample (automation[nextAutomationPoint]) < position; ++nextAutomationPoint)
+        passedPoints[automation[nextAutomationPoint].parameterIndex] = (int) nextAutomationPoint;
+
+    bool queued = true;
+
+    for (auto point : passedPoints)
+        if (point >= 0)
+            queued &= processor->scheduleParameterChange (0, automation[(size_t) point].parameterIndex, automation[(size_t) point].value);
+
+    for (; nextAutomationPoint < automation.size(); ++nextAutomationPoint)
+    {
+        const auto& point = automation[nextAutomationPoint];
+        const auto offset = getSample (point) - position;
+
+        if (offset >= numSamples)
+            break;
+
+        queued &= processor->scheduleParameterChange ((int) offset, point.parameterIndex, point.value);
+    }
+
+    return queued ? juce::Result::ok()
+                  : juce::Result::fail ("Too many automation changes in the block at sample " + juce::String (position));
+}
+
+juce::int64 OfflineRenderer::getTailLengthSamples (double sampleRate) const
+{
+    const auto seconds = settings.tailSeconds >= 0.0 ? settings.tailSeconds
+                                                     : juce::jmin (processor->getTailLengthSeconds(), settings.maxTailSeconds);
+
+    return (juce::int64) (seconds * sampleRate);
+}
+
+juce::Result OfflineRenderer::process (MappedAudioInput& input, juce::int64 start, juce::int64 end,
+                                       juce::int64 preRoll, const BlockSink& sink)
+{
+    const auto inputLength = input.getReader().lengthInSamples;
+    const auto first = juce::jmax ((juce::int64) 0, start - preRoll);
+
+    // The reverb warms up over the pre-roll, but the tremolo has no memory,
+    // so it's moved straight to where it would be.
+    processor->setTremoloPosition (first);
+
+    for (auto position = first; position < end;)
+    {
+        const auto blockEnd = juce::jmin (position < start ? start : end, position + settings.blockSize);
+        const auto numSamples = (int) (blockEnd - position);
+
+        // A view of the first numSamples of the buffer, so the processor sees
+        // the real length of the last block.
+        juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+        // The output channels the input doesn't fill, and everything past
+        // the end of the input, are silent.
+        block.clear();
+
+        if (position < inputLength && ! input.read (block, position, numSamples))
+            return juce::Result::fail ("Read error at sample " + juce::String (position));
+
+        auto result = scheduleAutomation (position, numSamples);
+
+        if (result.failed())
+            return result;
+
+        processor->processBlock (block, midi);
+
+        if (position >= start && ! sink (block, position))
+            return juce::Result::fail ("Write error at sample " + juce::String (position));
+
+        position = blockEnd;
+    }
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "MappedAudioInput.h"
+#include "BackgroundWriter.h"
+
+//==============================================================================
+/** How to set up the processor for a render. */
+struct RenderSettings
+{
+    /** Parameter ID to value, as text the parameter parses: a number in its
+        own range, e.g. size=0.8, or a choice by name, e.g. algorithm=FDN.
+    */
+    juce::StringPairArray parameterValues;
+
+    /** A state saved by the plugin, as XML or as the host's binary chunk. */
+    juce::File preset;
+
+    /** An impulse response for the convolution algorithm. */
+    juce::File impulseResponse;
+
+    /** Timed changes to the reverb parameters, one per line: the time in
+        seconds from the start of the input, the parameter ID and its value
+        as --param takes it, e.g. "2.5 freeze on". Lines starting with # are
+        comments. Each change lands on its own sample.
+    */
+    juce::File automation;
+
+    int blockSize = 512;
+
+    /** Silence rendered after the input, or negative to use the processor's
+        own tail length, capped at maxTailSeconds.
+    */
+    double tailSeconds = -1.0;
+    double maxTailSeconds = 30.0;
+
+    /** Renders a mono input to a stereo output. */
+    bool monoToStereo = false;
+
+    /** Splits a single file into this many pieces, rendered at once. */
+    int numSegments = 1;
+
+    /** How much of the input each piece runs through first, to warm up the
+        reverb, or negative to use the processor's tail length.
+    */
+    double preRollSeconds = -1.0;
+
+    /** The largest difference allowed between two pieces where they meet. */
+    double seamToleranceDecibels = -90.0;
+};
+
+//==============================================================================
+/** How long a render took. */
+struct RenderStats
+{
+    juce::int64 numSamples = 0;
+    double sampleRate = 0.0;
+    double wallSeconds = 0.0;
+
+    double getAudioSeconds() const noexcept     { return sampleRate > 0.0 ? (double) numSamples / sampleRate : 0.0; }
+    double getRealtimeFactor() const noexcept   { return wallSeconds > 0.0 ? getAudioSeconds() / wallSeconds : 0.0; }
+};
+
+//==============================================================================
+/**
+    Runs audio files through its own SimpleReverbAudioProcessor, without an
+    editor or a host.
+
+    The processor is created and set up from the RenderSettings once, and
+    prepared again for each file's rate and channel count. Not thread-safe:
+    use one renderer per thread.
+*/
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer (const RenderSettings& settings);
+
+    /** Checks the settings, e.g. that every parameter exists. Call this before
+        rendering, as the settings are only applied once.
+    */
+    juce::Result initialise();
+
+    /** Renders input to output, followed by the tail. The output format is
+        picked from its extension. The input is read through a memory-mapped
+        window and the output written on a background thread, so neither
+        file is ever held in memory.
+    */
+    juce::Result renderFile (const juce::File& input, const juce::File& output, RenderStats& stats);
+
+    //==============================================================================
+    /** Receives each processed block along with the position of its first
+        sample. Returns false to stop the render.
+    */
+    using BlockSink = std::function<bool (const juce::AudioBuffer<float>& block, juce::int64 position)>;
+
+    /** Sets the processor up for a file with this many channels at this rate,
+        starting from a clean tail.
+    */
+    juce::Result prepare (int numInputChannels, double sampleRate);
+
+    /** Runs the input's samples from start - preRoll up to end through the
+        processor, and hands every block from start on to the sink. The
+        pre-roll only warms up the reverb, and anything past the end of the
+        input is silence. Blocks never straddle start. Call prepare() first.
+    */
+    juce::Result process (MappedAudioInput& input, juce::int64 start, juce::int64 end,
+                          juce::int64 preRoll, const BlockSink& sink);
+
+    /** Queues the automation that lands in the numSamples from position with
+        the processor. Call it before each block, in order, after prepare().
+        Of the changes before position that haven't been queued yet, only the
+        latest value of each parameter is queued, at the block's first sample.
+    */
+    juce::Result scheduleAutomation (juce::int64 position, int numSamples);
+
+    /** The silence rendered after an input at this rate. */
+    juce::int64 getTailLengthSamples (double sampleRate) const;
+
+    /** Creates a writer for output that matches the reader's rate, and its
+        bit depth where the output format allows.
+    */
+    juce::Result createWriter (const juce::File& output, const juce::AudioFormatReader& reader,
+                               int numChannels, std::unique_ptr<juce::AudioFormatWriter>& writer);
+
+    /** The same, with the writer moved onto its own thread. */
+    juce::Result createBackgroundWriter (const juce::File& output, const juce::AudioFormatReader& reader,
+                                         int numChannels, std::unique_ptr<BackgroundWriter>& writer);
+
+    juce::AudioFormatManager& getFormatManager() noexcept   { return formatManager; }
+    const RenderSettings& getSettings() const noexcept      { return settings; }
+
+    SimpleReverbAudioProcessor& getProcessor() noexcept { return *processor; }
+
+    /** The ID, name and current value of each of the processor's parameters. */
+    static juce::StringArray describeParameters (SimpleReverbAudioProcessor& processor);
+
+private:
+    //==============================================================================
+    juce::Result applySettings();
+    juce::Result loadAutomation();
+    void settle();
+
+    static juce::AudioChannelSet getChannelSet (int numChannels);
+
+    RenderSettings settings;
+    std::unique_ptr<SimpleReverbAudioProcessor> processor;
+    juce::AudioFormatManager formatManager;
+
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+
+    struct AutomationPoint
+    {
+        double seconds;
+        int parameterIndex;     // as the processor's scheduleParameterChange() takes it
+        float value;
+    };
+
+    std::vector<AutomationPoint> automation;   // in time order
+    size_t nextAutomationPoint = 0;
+    double currentSampleRate = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -0,0 +1,132 @@
+#include "RenderJobPool.h"
+
+//==============================================================================
+class RenderJobPool::Worker  : public juce::Thread
+{
+public:
+    Worker (RenderJobPool& p, int workerIndex, const RenderSettings& settings)
+        : juce::Thread ("Render worker " + juce::String (workerIndex)),
+          pool (p),
+          index (workerIndex),
+          renderer (settings)
+    {
+    }
+
+    ~Worker() override
+    {
+        stopThread (-1);
+    }
+
+    void run() override
+    {
+        RenderJob job;
+
+        while (! threadShouldExit() && pool.getNextJob (index, job))
+            render (job);
+    }
+
+    juce::CriticalSection lock;
+    std::deque<RenderJob> jobs;
+    OfflineRenderer renderer;
+
+private:
+    void render (const RenderJob& job)
+    {
+        // Each file is written under a temporary name and only moved into
+        // place once it's complete, so a crash never leaves a truncated file
+        // that looks finished.
+        const auto partial = job.output.getSiblingFile (job.output.getFileNameWithoutExtension()
+                                                          + ".partial" + job.output.getFileExtension());
+
+        RenderStats stats;
+        auto result = renderer.renderFile (job.input, partial, stats);
+
+        if (result.wasOk() && ! partial.moveFileTo (job.output))
+            result = juce::Result::fail ("Can't move the render to " + job.output.getFullPathName());
+
+        if (result.failed())
+            partial.deleteFile();
+
+        pool.callback (job, result, stats);
+    }
+
+    RenderJobPool& pool;
+    const int index;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+};
+
+//==============================================================================
+RenderJobPool::RenderJobPool (const RenderSettings& s, int numWorkersToUse)
+    : settings (s),
+      numWorkers (juce::jmax (1, numWorkersToUse))
+{
+}
+
+RenderJobPool::~RenderJobPool()
+{
+    workers.clear();
+}
+
+juce::Result RenderJobPool::initialise()
+{
+    workers.clear();
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto result = workers.add (new Worker (*this, i, settings))->renderer.initialise();
+
+        if (result.failed())
+            return result;
+    }
+
+    return juce::Result::ok();
+}
+
+void RenderJobPool::run (std::vector<RenderJob> jobs, Callback onFinished)
+{
+    jassert (workers.size() == numWorkers);
+
+    callback = std::move (onFinished);
+
+    std::stable_sort (jobs.begin(), jobs.end(),
+                      [] (const RenderJob& a, const RenderJob& b) { return a.size > b.size; });
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+        workers.getUnchecked ((int) (i % (size_t) numWorkers))->jobs.push_back (jobs[i]);
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+}
+
+bool RenderJobPool::getNextJob (int workerIndex, RenderJob& job)
+{
+    // The worker's own queue first, from the front, then the others' from
+    // the back.
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto& worker = *workers.getUnchecked ((workerIndex + i) % numWorkers);
+        const juce::ScopedLock sl (worker.lock);
+
+        if (worker.jobs.empty())
+            continue;
+
+        if (i == 0)
+        {
+            job = worker.jobs.front();
+            worker.jobs.pop_front();
+        }
+        else
+        {
+            job = worker.jobs.back();
+            worker.jobs.pop_back();
+        }
+
+        return true;
+    }
+
+    return false;
+}
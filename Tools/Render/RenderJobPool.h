@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+#include <deque>
+
+//==============================================================================
+/** One file to render. */
+struct RenderJob
+{
+    juce::File input, output;
+    juce::int64 size = 0;   // the input's size in bytes, used to order the jobs
+};
+
+//==============================================================================
+/**
+    Renders a batch of files on several threads, each with its own
+    OfflineRenderer and so its own processor.
+
+    Every worker has its own queue. The jobs are sorted longest first and
+    dealt out in turn, so each queue starts with a similar amount of work.
+    A worker takes jobs from the front of its own queue, and once that's
+    empty it steals from the back of the others'. The long files start early
+    and the short ones fill in the gaps, so no core sits idle while another
+    still has a queue of files.
+*/
+class RenderJobPool
+{
+public:
+    using Callback = std::function<void (const RenderJob&, const juce::Result&, const RenderStats&)>;
+
+    RenderJobPool (const RenderSettings& settings, int numWorkers);
+    ~RenderJobPool();
+
+    /** Creates the workers' renderers. They're built here, on the calling
+        thread, rather than on the workers.
+    */
+    juce::Result initialise();
+
+    /** Renders every job and returns once they've all finished. The callback
+        is called on the worker threads as each job finishes.
+    */
+    void run (std::vector<RenderJob> jobs, Callback onFinished);
+
+    int getNumWorkers() const noexcept { return numWorkers; }
+
+private:
+    //==============================================================================
+    class Worker;
+
+    bool getNextJob (int workerIndex, RenderJob& job);
+
+    RenderSettings settings;
+    int numWorkers;
+
+    juce::OwnedArray<Worker> workers;
+    Callback callback;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJobPool)
+};
@@ -0,0 +1,83 @@
+#include "RenderManifest.h"
+
+//==============================================================================
+juce::Result RenderManifest::open (const juce::File& file, bool resume)
+{
+    const juce::ScopedLock sl (lock);
+
+    finished.clear();
+
+    if (resume && file.existsAsFile())
+    {
+        juce::StringArray lines;
+        file.readLines (lines);
+
+        for (auto& line : lines)
+        {
+            juce::StringArray fields;
+            fields.addTokens (line, "\t", {});
+
+            if (fields.size() < 2)
+                continue;
+
+            // Later lines win, so a file that failed after an earlier
+            // success is rendered again.
+            if (fields[0] == "done" && fields.size() >= 3)
+                finished[fields[1]] = fields[2];
+            else if (fields[0] == "failed")
+                finished.erase (fields[1]);
+        }
+    }
+    else
+    {
+        file.deleteFile();
+    }
+
+    stream = file.createOutputStream();
+
+    if (stream == nullptr || stream->failedToOpen())
+    {
+        stream.reset();
+        return juce::Result::fail ("Can't write the manifest " + file.getFullPathName());
+    }
+
+    return juce::Result::ok();
+}
+
+bool RenderManifest::isDone (const juce::File& input, const juce::File& output) const
+{
+    const juce::ScopedLock sl (lock);
+
+    auto entry = finished.find (input.getFullPathName());
+
+    return entry != finished.end()
+            && entry->second == output.getFullPathName()
+            && output.existsAsFile();
+}
+
+void RenderManifest::markDone (const juce::File& input, const juce::File& output, const RenderStats& stats)
+{
+    const juce::ScopedLock sl (lock);
+
+    finished[input.getFullPathName()] = output.getFullPathName();
+    append ({ "done", input.getFullPathName(), output.getFullPathName(),
+              juce::String (stats.getAudioSeconds(), 3), juce::String (stats.wallSeconds, 3) });
+}
+
+void RenderManifest::markFailed (const juce::File& input, const juce::String& error)
+{
+    const juce::ScopedLock sl (lock);
+
+    finished.erase (input.getFullPathName());
+    append ({ "failed", input.getFullPathName(), error.replaceCharacters ("\t\r\n", "   ") });
+}
+
+void RenderManifest::append (const juce::StringArray& fields)
+{
+    if (stream == nullptr)
+        return;
+
+    // Flushed line by line, so a crash loses at most the files in flight.
+    stream->writeText (fields.joinIntoString ("\t") + "\n", false, false, nullptr);
+    stream->flush();
+}
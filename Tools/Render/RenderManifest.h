@@ -0,0 +1,43 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/**
+    A log of the files a batch has finished, so that a batch that crashed or
+    was stopped can be run again and only render what's missing.
+
+    Every finished or failed file is appended as one tab-separated line and
+    flushed straight away:
+
+        done    <input>    <output>    <audio seconds>    <wall seconds>
+        failed  <input>    <error>
+
+    A file counts as done if its last line says so and its output still
+    exists. Failed files are tried again. All the methods are thread-safe.
+*/
+class RenderManifest
+{
+public:
+    RenderManifest() = default;
+
+    /** Opens the manifest for appending. With resume, the entries already in
+        it are read first; otherwise it's started again.
+    */
+    juce::Result open (const juce::File& file, bool resume);
+
+    bool isDone (const juce::File& input, const juce::File& output) const;
+
+    void markDone (const juce::File& input, const juce::File& output, const RenderStats& stats);
+    void markFailed (const juce::File& input, const juce::String& error);
+
+private:
+    void append (const juce::StringArray& fields);
+
+    juce::CriticalSection lock;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::map<juce::String, juce::String> finished;   // input path to output path
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderManifest)
+};
@@ -0,0 +1,278 @@
+#include "SegmentedRenderer.h"
+
+//==============================================================================
+class SegmentedRenderer::Segment  : public juce::Thread
+{
+public:
+    Segment (int index, const RenderSettings& settings)
+        : juce::Thread ("Render segment " + juce::String (index)),
+          renderer (settings)
+    {
+    }
+
+    ~Segment() override
+    {
+        stopThread (-1);
+        tempFile.deleteFile();
+    }
+
+    /** Renders [start, end) of the output, plus up to seamLength samples past
+        end for the seam check.
+    */
+    void setRange (const juce::File& newInput, const juce::File& newTempFile,
+                   juce::int64 newStart, juce::int64 newEnd, juce::int64 newCheckEnd,
+                   juce::int64 newPreRoll, int seamLength)
+    {
+        input = newInput;
+        tempFile = newTempFile;
+        start = newStart;
+        end = newEnd;
+        checkEnd = newCheckEnd;
+        preRoll = newPreRoll;
+
+        head.setSize (1, seamLength);
+        tail.setSize (1, seamLength);
+    }
+
+    void run() override
+    {
+        result = render();
+    }
+
+    OfflineRenderer renderer;
+    juce::File tempFile;
+    juce::Result result { juce::Result::ok() };
+
+    // The first and the overhanging samples, compared at the seams.
+    juce::AudioBuffer<float> head, tail;
+
+private:
+    juce::Result render()
+    {
+        MappedAudioInput mappedInput;
+        auto result = mappedInput.open (renderer.getFormatManager(), input);
+
+        if (result.failed())
+            return result;
+
+        const auto& reader = mappedInput.getReader();
+        result = renderer.prepare ((int) reader.numChannels, reader.sampleRate);
+
+        if (result.failed())
+            return result;
+
+        const auto numChannels = renderer.getProcessor().getTotalNumOutputChannels();
+        const auto seamLength = head.getNumSamples();
+
+        head.setSize (numChannels, seamLength);
+        tail.setSize (numChannels, seamLength);
+        head.clear();
+        tail.clear();
+
+        // The segments are kept as float, so stitching doesn't lose anything.
+        tempFile.deleteFile();
+        auto stream = tempFile.createOutputStream();
+
+        if (stream == nullptr || stream->failedToOpen())
+            return juce::Result::fail ("Can't write to " + tempFile.getFullPathName());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> formatWriter (wav.createWriterFor (stream.get(), reader.sampleRate,
+                                                                                    (unsigned int) numChannels, 32, {}, 0));
+
+        if (formatWriter == nullptr)
+            return juce::Result::fail ("Can't write " + tempFile.getFullPathName());
+
+        stream.release();
+
+        BackgroundWriter writer (std::move (formatWriter), numChannels,
+                                 BackgroundWriter::getDefaultCapacity (reader.sampleRate, renderer.getSettings().blockSize));
+
+        result = renderer.process (mappedInput, start, checkEnd, preRoll,
+                                 [&] (const juce::AudioBuffer<float>& block, juce::int64 position)
+        {
+            const auto blockEnd = position + block.getNumSamples();
+
+            copyOverlap (block, position, head, start);
+            copyOverlap (block, position, tail, end);
+
+            const auto numToWrite = (int) (juce::jmin (blockEnd, end) - position);
+
+            return numToWrite <= 0 || writer.write (block, numToWrite);
+        });
+
+        if (! writer.finish() && result.wasOk())
+            return juce::Result::fail ("Can't finish writing " + tempFile.getFullPathName());
+
+        return result;
+    }
+
+    /** Copies whatever part of block, which starts at position, falls within
+        the destination, which starts at destinationStart.
+    */
+    static void copyOverlap (const juce::AudioBuffer<float>& block, juce::int64 position,
+                             juce::AudioBuffer<float>& destination, juce::int64 destinationStart)
+    {
+        const auto first = juce::jmax (position, destinationStart);
+        const auto last  = juce::jmin (position + block.getNumSamples(), destinationStart + destination.getNumSamples());
+
+        if (first >= last)
+            return;
+
+        for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+            destination.copyFrom (ch, (int) (first - destinationStart), block, ch, (int) (first - position), (int) (last - first));
+    }
+
+    juce::File input;
+    juce::int64 start = 0, end = 0, checkEnd = 0, preRoll = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Segment)
+};
+
+//==============================================================================
+SegmentedRenderer::SegmentedRenderer (const RenderSettings& s)
+    : settings (s)
+{
+}
+
+SegmentedRenderer::~SegmentedRenderer()
+{
+    segments.clear();
+}
+
+juce::Result SegmentedRenderer::initialise()
+{
+    segments.clear();
+
+    for (int i = 0; i < juce::jmax (1, settings.numSegments); ++i)
+    {
+        auto result = segments.add (new Segment (i, settings))->renderer.initialise();
+
+        if (result.failed())
+            return result;
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result SegmentedRenderer::renderFile (const juce::File& input, const juce::File& output, RenderStats& stats)
+{
+    jassert (! segments.isEmpty());
+
+    auto& firstRenderer = segments.getFirst()->renderer;
+    MappedAudioInput mappedInput;
+    auto opened = mappedInput.open (firstRenderer.getFormatManager(), input);
+
+    if (opened.failed())
+        return opened;
+
+    const auto& reader = mappedInput.getReader();
+    const auto sampleRate = reader.sampleRate;
+    const auto tailSeconds = firstRenderer.getProcessor().getTailLengthSeconds();
+
+    if (settings.preRollSeconds < 0.0 && ! std::isfinite (tailSeconds))
+        return juce::Result::fail ("A frozen reverb never decays, so the file can't be split");
+
+    const auto total = reader.lengthInSamples + firstRenderer.getTailLengthSamples (sampleRate);
+
+    preRollSamples = (juce::int64) std::ceil ((settings.preRollSeconds >= 0.0 ? settings.preRollSeconds : tailSeconds) * sampleRate);
+
+    // Segments much shorter than the pre-roll would spend most of their time
+    // warming up.
+    const auto minSegmentLength = juce::jmax (preRollSamples, (juce::int64) settings.blockSize);
+    numSegmentsUsed = (int) juce::jlimit ((juce::int64) 1, (juce::int64) segments.size(), total / minSegmentLength);
+
+    const auto segmentLength = (total + numSegmentsUsed - 1) / numSegmentsUsed;
+    const auto seamLength = (int) juce::jmin ((juce::int64) 4096, segmentLength);
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < numSegmentsUsed; ++i)
+    {
+        const auto start = i * segmentLength;
+        const auto end = i == numSegmentsUsed - 1 ? total : juce::jmin (total, start + segmentLength);
+        const auto checkEnd = i == numSegmentsUsed - 1 ? end : juce::jmin (total, end + seamLength);
+
+        auto* segment = segments.getUnchecked (i);
+        segment->setRange (input, output.getSiblingFile (output.getFileNameWithoutExtension() + ".segment" + juce::String (i) + ".wav"),
+                           start, end, checkEnd, preRollSamples, seamLength);
+        segment->startThread();
+    }
+
+    for (int i = 0; i < numSegmentsUsed; ++i)
+        segments.getUnchecked (i)->waitForThreadToExit (-1);
+
+    for (int i = 0; i < numSegmentsUsed; ++i)
+        if (segments.getUnchecked (i)->result.failed())
+            return segments.getUnchecked (i)->result;
+
+    // Each seam compares the overhang of one segment with the start of the
+    // next, which is the same stretch of output rendered with less warm-up.
+    auto worstError = 0.0f;
+
+    for (int i = 0; i + 1 < numSegmentsUsed; ++i)
+    {
+        const auto& tail = segments.getUnchecked (i)->tail;
+        const auto& head = segments.getUnchecked (i + 1)->head;
+
+        for (int ch = 0; ch < tail.getNumChannels(); ++ch)
+            for (int n = 0; n < tail.getNumSamples(); ++n)
+                worstError = juce::jmax (worstError, std::abs (tail.getSample (ch, n) - head.getSample (ch, n)));
+    }
+
+    worstSeamErrorDecibels = juce::Decibels::gainToDecibels ((double) worstError, -std::numeric_limits<double>::infinity());
+
+    auto result = stitch (output, reader, numSegmentsUsed);
+
+    stats.numSamples = total;
+    stats.sampleRate = sampleRate;
+    stats.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    if (result.wasOk() && worstSeamErrorDecibels > settings.seamToleranceDecibels)
+        return juce::Result::fail ("The worst seam is off by " + juce::String (worstSeamErrorDecibels, 1) + " dB, above the "
+                                     + juce::String (settings.seamToleranceDecibels, 1) + " dB tolerance. "
+                                     "A longer --pre-roll should bring it down");
+
+    return result;
+}
+
+juce::Result SegmentedRenderer::stitch (const juce::File& output, const juce::AudioFormatReader& reader, int numSegments)
+{
+    auto& firstRenderer = segments.getFirst()->renderer;
+    const auto numChannels = firstRenderer.getProcessor().getTotalNumOutputChannels();
+    std::unique_ptr<BackgroundWriter> writer;
+
+    auto result = firstRenderer.createBackgroundWriter (output, reader, numChannels, writer);
+
+    if (result.failed())
+        return result;
+
+    // Copied a block at a time, so no segment is ever held whole.
+    const auto blockSize = juce::jmax (firstRenderer.getSettings().blockSize, 8192);
+    juce::AudioBuffer<float> block (numChannels, blockSize);
+
+    for (int i = 0; i < numSegments && result.wasOk(); ++i)
+    {
+        const auto& tempFile = segments.getUnchecked (i)->tempFile;
+        MappedAudioInput segmentInput;
+        result = segmentInput.open (firstRenderer.getFormatManager(), tempFile);
+
+        const auto length = result.wasOk() ? segmentInput.getReader().lengthInSamples : 0;
+
+        for (juce::int64 position = 0; position < length && result.wasOk(); position += blockSize)
+        {
+            const auto numSamples = (int) juce::jmin ((juce::int64) blockSize, length - position);
+
+            if (! segmentInput.read (block, position, numSamples) || ! writer->write (block, numSamples))
+                result = juce::Result::fail ("Can't copy " + tempFile.getFullPathName() + " into the output");
+        }
+
+        if (result.wasOk())
+            tempFile.deleteFile();
+    }
+
+    if (! writer->finish() && result.wasOk())
+        result = juce::Result::fail ("Can't finish writing " + output.getFullPathName());
+
+    return result;
+}
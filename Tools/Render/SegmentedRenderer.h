@@ -0,0 +1,59 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/**
+    Renders one long file on several threads by splitting it into segments,
+    each with its own OfflineRenderer.
+
+    Each segment first runs the stretch of input just before it through its
+    processor and throws that output away. That pre-roll defaults to the
+    reverb's tail length, the time the tail takes to fall by 120 dB, so by
+    the segment's first sample the tank holds what it would have in a
+    straight render. The tremolo is moved to the right phase directly.
+
+    Each segment but the last also renders a short stretch past its end.
+    That's compared with the start of the next segment to measure how far
+    apart they are where they're joined. The segments are written to
+    temporary files and then copied into the output in order.
+
+    A frozen reverb never decays, so it can't be split.
+*/
+class SegmentedRenderer
+{
+public:
+    SegmentedRenderer (const RenderSettings& settings);
+    ~SegmentedRenderer();
+
+    /** Creates a renderer per segment. */
+    juce::Result initialise();
+
+    /** Renders input to output, followed by the tail. Fails if the worst
+        seam is above the settings' tolerance, though the output is kept.
+    */
+    juce::Result renderFile (const juce::File& input, const juce::File& output, RenderStats& stats);
+
+    /** From the last render: the number of segments, the pre-roll each one
+        had, and the largest difference at a seam, in dB full scale.
+    */
+    int getNumSegmentsUsed() const noexcept                 { return numSegmentsUsed; }
+    juce::int64 getPreRollSamples() const noexcept          { return preRollSamples; }
+    double getWorstSeamErrorDecibels() const noexcept       { return worstSeamErrorDecibels; }
+
+private:
+    //==============================================================================
+    class Segment;
+
+    juce::Result stitch (const juce::File& output, const juce::AudioFormatReader& reader, int numSegments);
+
+    RenderSettings settings;
+    juce::OwnedArray<Segment> segments;
+
+    int numSegmentsUsed = 0;
+    juce::int64 preRollSamples = 0;
+    double worstSeamErrorDecibels = -std::numeric_limits<double>::infinity();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SegmentedRenderer)
+};
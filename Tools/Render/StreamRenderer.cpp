@@ -0,0 +1,223 @@
+#include "StreamRenderer.h"
+
+//==============================================================================
+int StreamFormat::getBytesPerSample() const noexcept
+{
+    switch (encoding)
+    {
+        case Encoding::int16:   return 2;
+        case Encoding::int24:   return 3;
+        case Encoding::int32:
+        case Encoding::float32:
+        default:                return 4;
+    }
+}
+
+bool StreamFormat::parseEncoding (const juce::String& name, Encoding& result)
+{
+    if      (name.equalsIgnoreCase ("f32"))  result = Encoding::float32;
+    else if (name.equalsIgnoreCase ("s16"))  result = Encoding::int16;
+    else if (name.equalsIgnoreCase ("s24"))  result = Encoding::int24;
+    else if (name.equalsIgnoreCase ("s32"))  result = Encoding::int32;
+    else                                     return false;
+
+    return true;
+}
+
+//==============================================================================
+StreamRenderer::StreamRenderer (const RenderSettings& settings, const StreamFormat& f)
+    : renderer (settings),
+      format (f)
+{
+}
+
+juce::Result StreamRenderer::initialise()
+{
+    if (format.numChannels <= 0 || format.sampleRate <= 0.0)
+        return juce::Result::fail ("The stream needs a sample rate and at least one channel");
+
+    return renderer.initialise();
+}
+
+juce::Result StreamRenderer::run (std::FILE* input, std::FILE* output, RenderStats& stats)
+{
+    auto result = renderer.prepare (format.numChannels, format.sampleRate);
+
+    if (result.failed())
+        return result;
+
+    auto& processor = renderer.getProcessor();
+    numOutputChannels = processor.getTotalNumOutputChannels();
+
+    const auto blockSize = renderer.getSettings().blockSize;
+    const auto inputFrameBytes  = (size_t) (format.numChannels * format.getBytesPerSample());
+    const auto outputFrameBytes = (size_t) (numOutputChannels * format.getBytesPerSample());
+
+    buffer.setSize (juce::jmax (format.numChannels, numOutputChannels), blockSize);
+    inputBytes.malloc ((size_t) blockSize * inputFrameBytes);
+    outputBytes.malloc ((size_t) blockSize * outputFrameBytes);
+
+    std::setvbuf (input,  nullptr, _IONBF, 0);
+    std::setvbuf (output, nullptr, _IONBF, 0);
+
+    processor.setTremoloPosition (0);
+
+    auto tailRemaining = renderer.getTailLengthSamples (format.sampleRate);
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    stats.numSamples = 0;
+    stats.sampleRate = format.sampleRate;
+
+    for (bool inputEnded = false;;)
+    {
+        auto numSamples = 0;
+
+        // fread() only comes back short at the end of the stream, so every
+        // block but the last is full.
+        if (! inputEnded)
+        {
+            numSamples = (int) std::fread (inputBytes, inputFrameBytes, (size_t) blockSize, input);
+
+            if (numSamples < blockSize)
+            {
+                if (std::ferror (input))
+                    return juce::Result::fail ("Read error after " + juce::String (stats.numSamples) + " samples");
+
+                inputEnded = true;
+            }
+        }
+
+        const auto isTail = numSamples == 0;
+
+        if (isTail)
+        {
+            if (tailRemaining <= 0)
+                break;
+
+            numSamples = (int) juce::jmin ((juce::int64) blockSize, tailRemaining);
+            tailRemaining -= numSamples;
+        }
+
+        // A view of the first numSamples of the buffer, so the processor sees
+        // the real length of the last block.
+        juce::AudioBuffer<float> block (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), numSamples);
+
+        if (isTail)
+            block.clear();
+        else
+            readSamples (inputBytes, block, format.numChannels, numSamples);
+
+        result = renderer.scheduleAutomation (stats.numSamples, numSamples);
+
+        if (result.failed())
+            return result;
+
+        processor.processBlock (block, midi);
+        writeSamples (block, outputBytes, numOutputChannels, numSamples);
+
+        if (std::fwrite (outputBytes, outputFrameBytes, (size_t) numSamples, output) != (size_t) numSamples)
+            return juce::Result::fail ("Write error after " + juce::String (stats.numSamples) + " samples");
+
+        stats.numSamples += numSamples;
+    }
+
+    std::fflush (output);
+    stats.wallSeconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+void StreamRenderer::readSamples (const char* source, juce::AudioBuffer<float>& block, int numChannels, int numSamples) const
+{
+    const auto bytesPerSample = format.getBytesPerSample();
+    const auto stride = numChannels * bytesPerSample;
+
+    // Output channels the input doesn't fill start silent.
+    for (int ch = numChannels; ch < block.getNumChannels(); ++ch)
+        block.clear (ch, 0, numSamples);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = block.getWritePointer (ch);
+        auto* src = source + ch * bytesPerSample;
+
+        switch (format.encoding)
+        {
+            case StreamFormat::Encoding::int16:
+                for (int n = 0; n < numSamples; ++n, src += stride)
+                    dest[n] = (float) (juce::int16) juce::ByteOrder::littleEndianShort (src) * (1.0f / 32768.0f);
+                break;
+
+            case StreamFormat::Encoding::int24:
+                for (int n = 0; n < numSamples; ++n, src += stride)
+                    dest[n] = (float) juce::ByteOrder::littleEndian24Bit (src) * (1.0f / 8388608.0f);
+                break;
+
+            case StreamFormat::Encoding::int32:
+                for (int n = 0; n < numSamples; ++n, src += stride)
+                    dest[n] = (float) ((double) (juce::int32) juce::ByteOrder::littleEndianInt (src) * (1.0 / 2147483648.0));
+                break;
+
+            case StreamFormat::Encoding::float32:
+            default:
+                for (int n = 0; n < numSamples; ++n, src += stride)
+                {
+                    auto bits = juce::ByteOrder::littleEndianInt (src);
+                    std::memcpy (dest + n, &bits, sizeof (float));
+                }
+                break;
+        }
+    }
+
+    // A mono stream rendered to stereo feeds both sides, as files do.
+    if (numChannels == 1 && numOutputChannels == 2)
+        block.copyFrom (1, 0, block, 0, 0, numSamples);
+}
+
+void StreamRenderer::writeSamples (const juce::AudioBuffer<float>& block, char* destination, int numChannels, int numSamples) const
+{
+    const auto bytesPerSample = format.getBytesPerSample();
+    const auto stride = numChannels * bytesPerSample;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* src = block.getReadPointer (ch);
+        auto* dest = destination + ch * bytesPerSample;
+
+        switch (format.encoding)
+        {
+            case StreamFormat::Encoding::int16:
+                for (int n = 0; n < numSamples; ++n, dest += stride)
+                {
+                    auto value = juce::ByteOrder::swapIfBigEndian ((juce::uint16) (juce::int16) juce::jlimit (-32768, 32767, juce::roundToInt (src[n] * 32768.0f)));
+                    std::memcpy (dest, &value, 2);
+                }
+                break;
+
+            case StreamFormat::Encoding::int24:
+                for (int n = 0; n < numSamples; ++n, dest += stride)
+                    juce::ByteOrder::littleEndian24BitToChars (juce::jlimit (-8388608, 8388607, juce::roundToInt (src[n] * 8388608.0f)), dest);
+                break;
+
+            case StreamFormat::Encoding::int32:
+                for (int n = 0; n < numSamples; ++n, dest += stride)
+                {
+                    auto value = juce::ByteOrder::swapIfBigEndian ((juce::uint32) (juce::int32) juce::jlimit (-2147483648.0, 2147483647.0, std::round ((double) src[n] * 2147483648.0)));
+                    std::memcpy (dest, &value, 4);
+                }
+                break;
+
+            case StreamFormat::Encoding::float32:
+            default:
+                for (int n = 0; n < numSamples; ++n, dest += stride)
+                {
+                    juce::uint32 bits;
+                    std::memcpy (&bits, src + n, sizeof (float));
+                    bits = juce::ByteOrder::swapIfBigEndian (bits);
+                    std::memcpy (dest, &bits, 4);
+                }
+                break;
+        }
+    }
+}
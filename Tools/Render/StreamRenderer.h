@@ -0,0 +1,74 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+
+#include <cstdio>
+
+//==============================================================================
+/** The layout of a raw, headerless stream of interleaved little-endian PCM. */
+struct StreamFormat
+{
+    enum class Encoding
+    {
+        float32,
+        int16,
+        int24,
+        int32
+    };
+
+    double sampleRate = 44100.0;
+    int numChannels = 2;
+    Encoding encoding = Encoding::float32;
+
+    int getBytesPerSample() const noexcept;
+
+    /** Reads an encoding named as f32, s16, s24 or s32. */
+    static bool parseEncoding (const juce::String& name, Encoding& encoding);
+};
+
+//==============================================================================
+/**
+    Filters a raw PCM stream, e.g. stdin to stdout, through an OfflineRenderer's
+    processor, so the plugin can sit in a pipeline between a decoder and an
+    encoder.
+
+    Each block is read straight into one byte buffer, converted into the
+    processor's buffer as it's deinterleaved, processed in place and
+    converted back into a second byte buffer for writing. The streams are
+    left unbuffered, as those blocks already are the buffers.
+
+    The tail follows once the input ends, as it does for files.
+*/
+class StreamRenderer
+{
+public:
+    StreamRenderer (const RenderSettings& settings, const StreamFormat& format);
+
+    /** Applies the settings. See OfflineRenderer::initialise(). */
+    juce::Result initialise();
+
+    /** Filters input into output until the input ends. */
+    juce::Result run (std::FILE* input, std::FILE* output, RenderStats& stats);
+
+    /** The output's channel count, which differs from the input's when a
+        mono stream is rendered to stereo.
+    */
+    int getNumOutputChannels() const noexcept   { return numOutputChannels; }
+
+private:
+    //==============================================================================
+    void readSamples (const char* source, juce::AudioBuffer<float>& block, int numChannels, int numSamples) const;
+    void writeSamples (const juce::AudioBuffer<float>& block, char* destination, int numChannels, int numSamples) const;
+
+    OfflineRenderer renderer;
+    StreamFormat format;
+
+    juce::AudioBuffer<float> buffer;
+    juce::HeapBlock<char> inputBytes, outputBytes;
+    juce::MidiBuffer midi;
+
+    int numOutputChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamRenderer)
+};